@@ -1,4 +1,8 @@
 #include "BigNumber.h"
+#include "TaskPool.h"
+#include <algorithm>
+#include <functional>
+#include <optional>
 
 BigNumber::BigNumber() : isNegative(false) {
     digits.push_back(0);
@@ -57,6 +61,16 @@ std::string BigNumber::toString() const {
     return res;
 }
 
+// FNV-1a，覆盖符号和全部数字
+size_t BigNumber::hash() const {
+    uint64_t h = 14695981039346656037ull ^ static_cast<uint64_t>(isNegative);
+    for (char d : digits) {
+        h ^= static_cast<unsigned char>(d);
+        h *= 1099511628211ull;
+    }
+    return static_cast<size_t>(h);
+}
+
 void BigNumber::removeLeadingZeros() {
     while (digits.size() > 1 && digits.back() == 0) {
         digits.pop_back();
@@ -168,6 +182,12 @@ BigNumber BigNumber::divide(const BigNumber& dividend, const BigNumber& divisor,
         remainder.digits.insert(remainder.digits.begin(), dividend.digits[i]);
         remainder.removeLeadingZeros();
 
+        // 余数位数少于除数时本位商必为 0，省去试商的乘法；模逆中商通常很短，这一步占了大头
+        if (!divisor.isNegative && remainder.digits.size() < divisor.digits.size()) {
+            result.digits[i] = 0;
+            continue;
+        }
+
         int x = 0, low = 0, high = 9;
         while (low <= high) {
             int mid = (low + high) / 2;
@@ -214,22 +234,239 @@ BigNumber BigNumber::powmod(const BigNumber& exponent, const BigNumber& modulus)
         throw std::invalid_argument("Modulo by zero");
 
     BarrettReducer reducer(modulus);
+    return powmod(exponent, reducer);
+}
+
+BigNumber BigNumber::powmod(const BigNumber& exponent, const BarrettReducer& reducer) const {
+    return powmodWords(exponent.toBinaryWords(), reducer);
+}
+
+// 指数按二进制从高位到低位扫描：e = 65537 只需 16 次平方加 1 次乘法
+BigNumber BigNumber::powmodWords(const std::vector<uint32_t>& exponent, const BarrettReducer& reducer) const {
+    size_t size = exponent.size();
+    while (size > 0 && exponent[size - 1] == 0) --size;
+    if (size == 0) return BigNumber(1);
 
     BigNumber base = reducer.reduce(*this);
-    BigNumber exp = exponent;
+    BigNumber result = base;
+    int bits = (size - 1) * 32 + (32 - __builtin_clz(exponent[size - 1]));
+    for (int i = bits - 2; i >= 0; --i) {
+        // 每步的乘积和约减中间量都在 arena 中，步末整体回收；reduce 返回的结果已在堆上
+        ArenaScope scope;
+        result = reducer.reduce(result * result);
+        if ((exponent[i / 32] >> (i % 32)) & 1) {
+            result = reducer.reduce(result * base);
+        }
+    }
+    return result;
+}
+
+BigNumber BigNumber::multiPowmod(const std::vector<std::pair<BigNumber, BigNumber>>& terms, const BigNumber& modulus) {
+    if (modulus == BigNumber(0))
+        throw std::invalid_argument("Modulo by zero");
+
+    BarrettReducer reducer(modulus);
+    return multiPowmod(terms, reducer);
+}
+
+// 窗口宽 w 时代价约为 t * (2^w + bits / w) 次乘法外加 bits 次公共平方，取使其最小的 w
+BigNumber BigNumber::multiPowmod(const std::vector<std::pair<BigNumber, BigNumber>>& terms, const BarrettReducer& reducer) {
+    std::vector<std::vector<uint32_t>> exponents;
+    int bits = 0;
+    for (const auto& term : terms) {
+        if (term.second.isNegative) throw std::invalid_argument("Negative exponent");
+        exponents.push_back(term.second.toBinaryWords());
+        std::vector<uint32_t>& words = exponents.back();
+        while (!words.empty() && words.back() == 0) words.pop_back();
+        if (!words.empty()) bits = std::max<int>(bits, (words.size() - 1) * 32 + (32 - __builtin_clz(words.back())));
+    }
+    if (bits == 0) return reducer.reduce(BigNumber(1));
+
+    int window = 1;
+    for (int w = 2; w <= 6; ++w) {
+        if ((1 << w) + bits / w < (1 << window) + bits / window) window = w;
+    }
+
+    // table[j][d - 1] = b_j^d，d = 1 .. 2^w - 1
+    std::vector<std::vector<BigNumber>> table(terms.size());
+    for (size_t j = 0; j < terms.size(); ++j) {
+        table[j].push_back(reducer.reduce(terms[j].first));
+        for (int d = 2; d < (1 << window); ++d) {
+            table[j].push_back(reducer.reduce(table[j].back() * table[j][0]));
+        }
+    }
+
+    auto windowAt = [window](const std::vector<uint32_t>& words, int low) {
+        int digit = 0;
+        for (int b = window - 1; b >= 0; --b) {
+            size_t w = (low + b) / 32;
+            digit = (digit << 1) | (w < words.size() ? (words[w] >> ((low + b) % 32)) & 1 : 0);
+        }
+        return digit;
+    };
+
     BigNumber result(1);
+    bool started = false;
+    int windows = (bits + window - 1) / window;
+    for (int i = windows - 1; i >= 0; --i) {
+        ArenaScope scope;
+        if (started) {
+            for (int s = 0; s < window; ++s) result = reducer.reduce(result * result);
+        }
+        for (size_t j = 0; j < terms.size(); ++j) {
+            int digit = windowAt(exponents[j], i * window);
+            if (digit == 0) continue;
+            // result 在作用域之外，表项的拷贝要经 detach 放到堆上
+            result = started ? reducer.reduce(result * table[j][digit - 1]) : scope.detach(table[j][digit - 1]);
+            started = true;
+        }
+    }
+    return result;
+}
 
-    while (exp > BigNumber(0)) {
-        if (exp.digits[0] % 2 == 1) {
-            result = reducer.reduce(result * base);
+namespace {
+const uint32_t kPow10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+}
+
+// 每次吸收 9 个十进制位：words = words * 10^9 + chunk
+std::vector<uint32_t> BigNumber::toBinaryWords() const {
+    std::vector<uint32_t> words;
+    for (size_t end = digits.size(); end > 0;) {
+        size_t begin = end >= 9 ? end - 9 : 0;
+        uint32_t chunk = 0;
+        for (size_t i = end; i-- > begin;) chunk = chunk * 10 + digits[i];
+
+        uint64_t carry = chunk;
+        for (auto& w : words) {
+            uint64_t current = uint64_t(w) * kPow10[end - begin] + carry;
+            w = static_cast<uint32_t>(current);
+            carry = current >> 32;
+        }
+        if (carry) words.push_back(static_cast<uint32_t>(carry));
+        end = begin;
+    }
+    return words;
+}
+
+// 先转成 10^9 进制：dec = dec * 2^32 + word，再展开成十进制位
+BigNumber BigNumber::fromBinaryWords(const std::vector<uint32_t>& words) {
+    std::vector<uint32_t> dec;
+    for (size_t i = words.size(); i-- > 0;) {
+        uint64_t carry = words[i];
+        for (auto& d : dec) {
+            uint64_t current = (uint64_t(d) << 32) + carry;
+            d = static_cast<uint32_t>(current % kPow10[9]);
+            carry = current / kPow10[9];
+        }
+        while (carry) {
+            dec.push_back(static_cast<uint32_t>(carry % kPow10[9]));
+            carry /= kPow10[9];
         }
-        base = reducer.reduce(base * base);
-        exp.rightShift1();
     }
 
+    BigNumber result;
+    result.digits.clear();
+    result.digits.reserve(dec.size() * 9 + 1);
+    for (uint32_t d : dec) {
+        for (int j = 0; j < 9; ++j) {
+            result.digits.push_back(d % 10);
+            d /= 10;
+        }
+    }
+    if (result.digits.empty()) result.digits.push_back(0);
+    result.removeLeadingZeros();
     return result;
 }
 
+BigNumber BigNumber::fromRandomBits(const std::vector<uint32_t>& buffer, int bits) {
+    if (bits < 0 || buffer.size() * 32 < static_cast<size_t>(bits))
+        throw std::invalid_argument("Random buffer too small");
+
+    std::vector<uint32_t> words(buffer.begin(), buffer.begin() + (bits + 31) / 32);
+    if (bits % 32) words.back() &= (uint32_t(1) << (bits % 32)) - 1;
+    return fromBinaryWords(words);
+}
+
+uint32_t BigNumber::modWord(uint32_t m) const {
+    uint64_t r = 0;
+    for (int i = digits.size() - 1; i >= 0; --i) {
+        r = (r * 10 + digits[i]) % m;
+    }
+    return static_cast<uint32_t>(r);
+}
+
+int BigNumber::bitLength() const {
+    std::vector<uint32_t> words = toBinaryWords();
+    while (!words.empty() && words.back() == 0) words.pop_back();
+    if (words.empty()) return 0;
+    return (words.size() - 1) * 32 + (32 - __builtin_clz(words.back()));
+}
+
+bool BigNumber::testBit(int i) const {
+    if (i == 0) return digits[0] & 1;
+    std::vector<uint32_t> words = toBinaryWords();
+    size_t w = i / 32;
+    return w < words.size() && ((words[w] >> (i % 32)) & 1);
+}
+
+void BigNumber::setBit(int i) {
+    std::vector<uint32_t> words = toBinaryWords();
+    if (words.size() <= static_cast<size_t>(i / 32)) words.resize(i / 32 + 1, 0);
+    words[i / 32] |= uint32_t(1) << (i % 32);
+    bool negative = isNegative;
+    *this = fromBinaryWords(words);
+    isNegative = negative;
+}
+
+BigNumber BigNumber::operator<<(int bits) const {
+    if (bits < 0) return *this >> -bits;
+    std::vector<uint32_t> words = toBinaryWords();
+    std::vector<uint32_t> shifted(bits / 32, 0);
+    uint32_t carry = 0;
+    int offset = bits % 32;
+    for (uint32_t w : words) {
+        shifted.push_back((w << offset) | carry);
+        carry = offset ? w >> (32 - offset) : 0;
+    }
+    if (carry) shifted.push_back(carry);
+
+    BigNumber result = fromBinaryWords(shifted);
+    result.isNegative = isNegative && !(result.digits.size() == 1 && result.digits[0] == 0);
+    return result;
+}
+
+BigNumber BigNumber::operator>>(int bits) const {
+    if (bits < 0) return *this << -bits;
+    std::vector<uint32_t> words = toBinaryWords();
+    size_t skip = bits / 32;
+    int offset = bits % 32;
+    std::vector<uint32_t> shifted;
+    for (size_t i = skip; i < words.size(); ++i) {
+        uint32_t high = (offset && i + 1 < words.size()) ? words[i + 1] << (32 - offset) : 0;
+        shifted.push_back((words[i] >> offset) | high);
+    }
+
+    BigNumber result = fromBinaryWords(shifted);
+    result.isNegative = isNegative && !(result.digits.size() == 1 && result.digits[0] == 0);
+    return result;
+}
+
+BigNumber BigNumber::operator&(const BigNumber& other) const {
+    std::vector<uint32_t> a = toBinaryWords();
+    std::vector<uint32_t> b = other.toBinaryWords();
+    a.resize(std::min(a.size(), b.size()));
+    for (size_t i = 0; i < a.size(); ++i) a[i] &= b[i];
+    return fromBinaryWords(a);
+}
+
+BigNumber BigNumber::operator|(const BigNumber& other) const {
+    std::vector<uint32_t> a = toBinaryWords();
+    std::vector<uint32_t> b = other.toBinaryWords();
+    if (a.size() < b.size()) a.resize(b.size(), 0);
+    for (size_t i = 0; i < b.size(); ++i) a[i] |= b[i];
+    return fromBinaryWords(a);
+}
+
 BigNumber BigNumber::modinv(const BigNumber& modulus) const {
     BigNumber a = *this, m = modulus;
     BigNumber m0 = m;
@@ -238,14 +475,15 @@ BigNumber BigNumber::modinv(const BigNumber& modulus) const {
     if (m == BigNumber(0))
         throw std::invalid_argument("Modulo by zero");
 
+    // 每步只做一次除法，同时得到商和余数
     while (a > BigNumber(1)) {
-        BigNumber q = a / m;
-        BigNumber t = m;
+        BigNumber r;
+        BigNumber q = divide(a, m, r);
 
-        m = a % m;
-        a = t;
-        t = y;
+        a = m;
+        m = r;
 
+        BigNumber t = y;
         y = x - q * y;
         x = t;
     }
@@ -312,31 +550,442 @@ BigNumber BigNumber::rightShiftDecimal(int n) const {
     return result;
 }
 
+BigNumber::MultiplyThresholds BigNumber::multiplyThresholds;
+BigNumber::ParallelMultiply BigNumber::parallelMultiply;
+
+namespace {
+
+thread_local int forkDepth = 0;
+
+struct ForkDepthGuard {
+    int saved;
+    explicit ForkDepthGuard(int depth) : saved(forkDepth) { forkDepth = depth; }
+    ~ForkDepthGuard() { forkDepth = saved; }
+};
+
+TaskPool& forkPool() {
+    TaskPool* pool = BigNumber::parallelMultiply.pool;
+    return pool ? *pool : TaskPool::shared();
+}
+
+// 默认的分派下限：Karatsuba 阈值的 32 倍，但不超过 NTT 阈值的一半，保证 Karatsuba/Toom-3 路径上也会分派
+size_t forkCutoff() {
+    if (BigNumber::parallelMultiply.minDigits) return BigNumber::parallelMultiply.minDigits;
+    const BigNumber::MultiplyThresholds& t = BigNumber::multiplyThresholds;
+    return std::max(2 * t.karatsuba, std::min(32 * t.karatsuba, t.ntt / 2));
+}
+
+bool shouldFork(size_t digits) {
+    return forkDepth < BigNumber::parallelMultiply.maxDepth
+        && digits >= forkCutoff()
+        && forkPool().workerCount() > 0;
+}
+
+// 最后一个任务在当前线程执行，其余交给任务池。派出去的任务关闭 arena，结果可以安全交回发起线程
+void forkJoin(std::vector<std::function<void()>>& tasks) {
+    TaskPool& pool = forkPool();
+    int depth = forkDepth + 1;
+
+    std::vector<TaskPool::TaskHandle> handles;
+    for (size_t i = 0; i + 1 < tasks.size(); ++i) {
+        std::function<void()>* fn = &tasks[i];
+        handles.push_back(pool.spawn([fn, depth]() {
+            ArenaSuspend suspend;
+            ForkDepthGuard guard(depth);
+            (*fn)();
+        }));
+    }
+
+    std::exception_ptr error;
+    try {
+        ForkDepthGuard guard(depth);
+        tasks.back()();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& handle : handles) {
+        try {
+            pool.join(handle);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+}
+
+// 计算一组相互独立的乘积 out[i] = lhs[i] * rhs[i]，操作数足够大时分派到任务池并行执行
+void BigNumber::multiplyProducts(const BigNumber* const lhs[], const BigNumber* const rhs[], BigNumber out[], size_t count, size_t digits) {
+    if (!shouldFork(digits)) {
+        for (size_t i = 0; i < count; ++i) out[i] = *lhs[i] * *rhs[i];
+        return;
+    }
+
+    std::vector<std::optional<BigNumber>> results(count);
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < count; ++i) {
+        tasks.push_back([&, i]() { results[i].emplace(*lhs[i] * *rhs[i]); });
+    }
+    forkJoin(tasks);
+    for (size_t i = 0; i < count; ++i) out[i] = std::move(*results[i]);
+}
+
 BigNumber BigNumber::absMultiply(const BigNumber& a, const BigNumber& b) {
-    if (a.digits.size() < 32 || b.digits.size() < 32) {
-        BigNumber result;
-        size_t n = a.digits.size();
-        size_t m = b.digits.size();
-        result.digits.assign(n + m, 0);
+    if (a.digits.size() < b.digits.size()) return absMultiply(b, a);
+
+    switch (multiplyAlgorithm(a.digits.size(), b.digits.size())) {
+        case MultiplyAlgorithm::Schoolbook: return schoolbookMultiply(a, b);
+        case MultiplyAlgorithm::Ntt: return nttMultiply(a, b);
+        case MultiplyAlgorithm::Unbalanced: return unbalancedMultiply(a, b);
+        case MultiplyAlgorithm::Toom3: return toom3Multiply(a, b);
+        case MultiplyAlgorithm::Karatsuba: break;
+    }
+    return karatsubaMultiply(a, b);
+}
 
-        for (size_t i = 0; i < n; ++i) {
-            int carry = 0;
-            for (size_t j = 0; j < m || carry; ++j) {
-                int digitA = a.digits[i];
-                int digitB = (j < m ? b.digits[j] : 0);
-                int64_t mul = result.digits[i + j] + digitA * digitB + carry;
-                result.digits[i + j] = mul % 10;
-                carry = mul / 10;
+BigNumber BigNumber::schoolbookMultiply(const BigNumber& a, const BigNumber& b) {
+    BigNumber result;
+    size_t n = a.digits.size();
+    size_t m = b.digits.size();
+    result.digits.assign(n + m, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        int carry = 0;
+        for (size_t j = 0; j < m || carry; ++j) {
+            int digitA = a.digits[i];
+            int digitB = (j < m ? b.digits[j] : 0);
+            int64_t mul = result.digits[i + j] + digitA * digitB + carry;
+            result.digits[i + j] = mul % 10;
+            carry = mul / 10;
+        }
+    }
+
+    result.removeLeadingZeros();
+    return result;
+}
+
+// 长短悬殊时把长的一方按短的一方的长度切片，逐片做平衡乘法后错位累加
+BigNumber BigNumber::unbalancedMultiply(const BigNumber& a, const BigNumber& b) {
+    size_t m = b.digits.size();
+    BigNumber result;
+    result.digits.assign(a.digits.size() + m + 1, 0);
+
+    for (size_t offset = 0; offset < a.digits.size(); offset += m) {
+        BigNumber slice;
+        slice.digits.assign(a.digits.begin() + offset, a.digits.begin() + std::min(a.digits.size(), offset + m));
+        slice.removeLeadingZeros();
+        BigNumber part = absMultiply(slice, b);
+
+        int carry = 0;
+        for (size_t i = 0; i < part.digits.size() || carry; ++i) {
+            int sum = result.digits[offset + i] + (i < part.digits.size() ? part.digits[i] : 0) + carry;
+            result.digits[offset + i] = sum % 10;
+            carry = sum / 10;
+        }
+    }
+
+    result.removeLeadingZeros();
+    return result;
+}
+
+// Toom-3：在 0, 1, -1, -2, ∞ 五点求值，按 Bodrato 的插值序列恢复系数
+BigNumber BigNumber::toom3Multiply(const BigNumber& a, const BigNumber& b) {
+    size_t k = (a.digits.size() + 2) / 3;
+
+    auto split = [k](const BigNumber& x, BigNumber parts[3]) {
+        for (size_t i = 0; i < 3; ++i) {
+            size_t begin = std::min(x.digits.size(), i * k);
+            size_t end = std::min(x.digits.size(), (i + 1) * k);
+            parts[i].digits.assign(x.digits.begin() + begin, x.digits.begin() + end);
+            if (parts[i].digits.empty()) parts[i].digits.push_back(0);
+            parts[i].removeLeadingZeros();
+        }
+    };
+
+    BigNumber x[3], y[3];
+    split(a, x);
+    split(b, y);
+
+    BigNumber xs = x[0] + x[2];
+    BigNumber ys = y[0] + y[2];
+    BigNumber x1 = xs + x[1], y1 = ys + y[1];
+    BigNumber xm1 = xs - x[1], ym1 = ys - y[1];
+    BigNumber xm2 = (xm1 + x[2]) * BigNumber(2) - x[0];
+    BigNumber ym2 = (ym1 + y[2]) * BigNumber(2) - y[0];
+
+    const BigNumber* lhs[5] = {&x[0], &x1, &xm1, &xm2, &x[2]};
+    const BigNumber* rhs[5] = {&y[0], &y1, &ym1, &ym2, &y[2]};
+    BigNumber products[5];
+    multiplyProducts(lhs, rhs, products, 5, a.digits.size());
+    const BigNumber& r0 = products[0];
+    const BigNumber& r1 = products[1];
+    const BigNumber& rm1 = products[2];
+    const BigNumber& rm2 = products[3];
+    const BigNumber& rinf = products[4];
+
+    BigNumber c3 = divideSmall(rm2 - r1, 3);
+    BigNumber c1 = divideSmall(r1 - rm1, 2);
+    BigNumber c2 = rm1 - r0;
+    c3 = divideSmall(c2 - c3, 2) + rinf * BigNumber(2);
+    c2 = c2 + c1 - rinf;
+    c1 = c1 - c3;
+
+    BigNumber result = r0 + c1.shiftLeft(k) + c2.shiftLeft(2 * k) + c3.shiftLeft(3 * k) + rinf.shiftLeft(4 * k);
+    result.isNegative = false;
+    return result;
+}
+
+namespace {
+
+// 两个 NTT 友好素数（原根均为 3），卷积系数上界 len * 9999^2 远小于两者之积，CRT 后可用 uint64 精确表示
+const uint32_t kNttMod1 = 998244353;
+const uint32_t kNttMod2 = 469762049;
+const uint32_t kNttRoot = 3;
+const int kNttLimbDigits = 4;
+const uint32_t kNttLimbBase = 10000;
+// 两个模数都支持的最大变换长度（2^23 整除 mod1 - 1）
+const size_t kMaxNttSize = size_t(1) << 23;
+
+uint32_t powMod32(uint64_t base, uint64_t exp, uint32_t mod) {
+    uint64_t result = 1;
+    base %= mod;
+    while (exp) {
+        if (exp & 1) result = result * base % mod;
+        base = base * base % mod;
+        exp >>= 1;
+    }
+    return static_cast<uint32_t>(result);
+}
+
+void ntt(std::vector<uint32_t>& a, bool invert, uint32_t mod) {
+    size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        uint64_t w = powMod32(kNttRoot, (mod - 1) / len, mod);
+        if (invert) w = powMod32(w, mod - 2, mod);
+        size_t half = len / 2;
+        std::vector<uint32_t> roots(half);
+        roots[0] = 1;
+        for (size_t k = 1; k < half; ++k) roots[k] = roots[k - 1] * w % mod;
+
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < half; ++k) {
+                uint32_t u = a[i + k];
+                uint32_t v = static_cast<uint32_t>(uint64_t(a[i + k + half]) * roots[k] % mod);
+                a[i + k] = u + v >= mod ? u + v - mod : u + v;
+                a[i + k + half] = u >= v ? u - v : u + mod - v;
             }
         }
+    }
 
-        result.removeLeadingZeros();
-        return result;
+    if (invert) {
+        uint64_t nInv = powMod32(n, mod - 2, mod);
+        for (auto& x : a) x = static_cast<uint32_t>(x * nInv % mod);
+    }
+}
+
+// 同一个数自乘时只做一次正变换，逐点平方
+std::vector<uint32_t> nttConvolve(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, bool square, size_t size, uint32_t mod) {
+    std::vector<uint32_t> fa(a.begin(), a.end());
+    fa.resize(size, 0);
+    ntt(fa, false, mod);
+    if (square) {
+        for (auto& x : fa) x = static_cast<uint32_t>(uint64_t(x) * x % mod);
+    } else {
+        std::vector<uint32_t> fb(b.begin(), b.end());
+        fb.resize(size, 0);
+        ntt(fb, false, mod);
+        for (size_t i = 0; i < size; ++i) fa[i] = static_cast<uint32_t>(uint64_t(fa[i]) * fb[i] % mod);
+    }
+    ntt(fa, true, mod);
+    return fa;
+}
+
+}
+
+std::vector<uint32_t> BigNumber::toNttLimbs() const {
+    std::vector<uint32_t> limbs((digits.size() + kNttLimbDigits - 1) / kNttLimbDigits, 0);
+    for (size_t i = digits.size(); i-- > 0;) {
+        uint32_t& limb = limbs[i / kNttLimbDigits];
+        limb = limb * 10 + digits[i];
+    }
+    return limbs;
+}
+
+BigNumber::MultiplyAlgorithm BigNumber::multiplyAlgorithm(size_t aDigits, size_t bDigits) {
+    if (aDigits < bDigits) std::swap(aDigits, bDigits);
+
+    if (bDigits < multiplyThresholds.karatsuba) return MultiplyAlgorithm::Schoolbook;
+    if (bDigits >= multiplyThresholds.ntt) {
+        // 两个操作数的基 10^4 肢数之和不能超过 NTT 的最大变换长度，否则先三等分
+        size_t limbs = (aDigits + kNttLimbDigits - 1) / kNttLimbDigits + (bDigits + kNttLimbDigits - 1) / kNttLimbDigits;
+        return limbs <= kMaxNttSize ? MultiplyAlgorithm::Ntt : MultiplyAlgorithm::Toom3;
+    }
+    if (aDigits >= 2 * bDigits) return MultiplyAlgorithm::Unbalanced;
+    if (bDigits >= multiplyThresholds.toom3) return MultiplyAlgorithm::Toom3;
+    return MultiplyAlgorithm::Karatsuba;
+}
+
+BigNumber BigNumber::nttMultiply(const BigNumber& a, const BigNumber& b) {
+    bool square = (&a == &b) || a.digits == b.digits;
+    std::vector<uint32_t> la = a.toNttLimbs();
+    std::vector<uint32_t> lb = square ? la : b.toNttLimbs();
+
+    size_t size = 1;
+    while (size < la.size() + lb.size()) size <<= 1;
+
+    std::vector<uint32_t> r1, r2;
+    if (shouldFork(a.digits.size())) {
+        std::vector<std::function<void()>> tasks = {
+            [&]() { r1 = nttConvolve(la, lb, square, size, kNttMod1); },
+            [&]() { r2 = nttConvolve(la, lb, square, size, kNttMod2); },
+        };
+        forkJoin(tasks);
+    } else {
+        r1 = nttConvolve(la, lb, square, size, kNttMod1);
+        r2 = nttConvolve(la, lb, square, size, kNttMod2);
+    }
+
+    // CRT：x = r1 + mod1 * ((r2 - r1) * mod1^-1 mod mod2)
+    const uint64_t mod1InvMod2 = powMod32(kNttMod1, kNttMod2 - 2, kNttMod2);
+    BigNumber result;
+    result.digits.assign((la.size() + lb.size()) * kNttLimbDigits + 20, 0);
+    uint64_t carry = 0;
+    size_t pos = 0;
+    for (size_t i = 0; i < la.size() + lb.size(); ++i) {
+        uint64_t diff = (r2[i] + kNttMod2 - r1[i] % kNttMod2) % kNttMod2;
+        uint64_t coefficient = r1[i] + uint64_t(kNttMod1) * (diff * mod1InvMod2 % kNttMod2);
+        carry += coefficient;
+        uint32_t limb = carry % kNttLimbBase;
+        carry /= kNttLimbBase;
+        for (int j = 0; j < kNttLimbDigits; ++j) {
+            result.digits[pos++] = limb % 10;
+            limb /= 10;
+        }
+    }
+    while (carry) {
+        result.digits[pos++] = carry % 10;
+        carry /= 10;
+    }
+
+    result.removeLeadingZeros();
+    return result;
+}
+
+BigNumber BigNumber::divideSmall(const BigNumber& a, int divisor) {
+    BigNumber result = a;
+    int64_t remainder = 0;
+    for (int i = result.digits.size() - 1; i >= 0; --i) {
+        int64_t current = result.digits[i] + remainder * 10;
+        result.digits[i] = current / divisor;
+        remainder = current % divisor;
+    }
+    result.removeLeadingZeros();
+    if (result.digits.size() == 1 && result.digits[0] == 0)
+        result.isNegative = false;
+    return result;
+}
+
+namespace {
+
+size_t karatsubaLeaf() {
+    return std::max<size_t>(BigNumber::multiplyThresholds.karatsuba, 4);
+}
+
+size_t karatsubaScratch(size_t n) {
+    if (n < karatsubaLeaf()) return 0;
+    size_t h = n - n / 2;
+    return 4 * h + karatsubaScratch(h);
+}
+
+// 系数不做进位：第 d 层输入系数不超过 9 * 2^d，乘积系数不超过 81 * n * 2^d，须留在 int64 以内
+bool karatsubaFitsInt64(size_t n) {
+    double bound = 81.0 * n;
+    for (size_t size = n; size >= karatsubaLeaf(); size -= size / 2) bound *= 2;
+    return bound < 4e18;
+}
+
+// 在未规范化的 int64 系数上做 Karatsuba：out 为 2n 个系数，scratch 至少 karatsubaScratch(n) 个
+void karatsubaPoly(const int64_t* a, const int64_t* b, size_t n, int64_t* out, int64_t* scratch) {
+    if (n < karatsubaLeaf()) {
+        std::fill(out, out + 2 * n, 0);
+        for (size_t i = 0; i < n; ++i) {
+            int64_t ai = a[i];
+            for (size_t j = 0; j < n; ++j) out[i + j] += ai * b[j];
+        }
+        return;
+    }
+
+    size_t m = n / 2, h = n - m;
+    karatsubaPoly(a, b, m, out, scratch);                 // z0 -> out[0, 2m)
+    karatsubaPoly(a + m, b + m, h, out + 2 * m, scratch); // z2 -> out[2m, 2n)
+
+    int64_t* sumA = scratch;
+    int64_t* sumB = scratch + h;
+    int64_t* mid = scratch + 2 * h;
+    for (size_t i = 0; i < h; ++i) {
+        sumA[i] = a[m + i] + (i < m ? a[i] : 0);
+        sumB[i] = b[m + i] + (i < m ? b[i] : 0);
     }
+    karatsubaPoly(sumA, sumB, h, mid, scratch + 4 * h);
+
+    // 中间项一次扣掉 z0 和 z2，再错位 m 加回
+    for (size_t i = 0; i < 2 * h; ++i) mid[i] -= (i < 2 * m ? out[i] : 0) + out[2 * m + i];
+    for (size_t i = 0; i < 2 * h; ++i) out[m + i] += mid[i];
+}
 
+}
+
+// 系数可以为负或超过 9，只在这里统一进位一次
+BigNumber BigNumber::fromCoefficients(const int64_t* coefficients, size_t count) {
+    BigNumber result;
+    result.digits.resize(count);
+    int64_t carry = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t value = coefficients[i] + carry;
+        int64_t digit = value % 10;
+        carry = value / 10;
+        if (digit < 0) {
+            digit += 10;
+            --carry;
+        }
+        result.digits[i] = static_cast<char>(digit);
+    }
+    while (carry > 0) {
+        result.digits.push_back(static_cast<char>(carry % 10));
+        carry /= 10;
+    }
+    result.removeLeadingZeros();
+    return result;
+}
+
+BigNumber BigNumber::karatsubaMultiply(const BigNumber& a, const BigNumber& b) {
     size_t n = std::max(a.digits.size(), b.digits.size());
     size_t m = n / 2;
 
+    // 不需要并行时整棵递归树都在 int64 系数上完成，所有中间结果共用一块预分配的缓冲区
+    if (!shouldFork(n) && karatsubaFitsInt64(n)) {
+        thread_local std::vector<int64_t> buffer;
+        buffer.assign(4 * n + karatsubaScratch(n), 0);
+        int64_t* x = buffer.data();
+        int64_t* y = x + n;
+        int64_t* out = y + n;
+        for (size_t i = 0; i < a.digits.size(); ++i) x[i] = a.digits[i];
+        for (size_t i = 0; i < b.digits.size(); ++i) y[i] = b.digits[i];
+        karatsubaPoly(x, y, n, out, out + 2 * n);
+
+        BigNumber result = fromCoefficients(out, 2 * n);
+        if (buffer.capacity() > (size_t(1) << 20)) std::vector<int64_t>().swap(buffer);
+        return result;
+    }
+
     BigNumber a0, a1, b0, b1;
     a0.digits.assign(a.digits.begin(), a.digits.begin() + std::min(a.digits.size(), m));
     a1.digits.assign(a.digits.begin() + std::min(a.digits.size(), m), a.digits.end());
@@ -348,35 +997,22 @@ BigNumber BigNumber::absMultiply(const BigNumber& a, const BigNumber& b) {
     b0.removeLeadingZeros();
     b1.removeLeadingZeros();
 
-    BigNumber z0 = absMultiply(a0, b0);
-    BigNumber z1 = absMultiply(a1, b1);
-    BigNumber z2 = absMultiply(a0 + a1, b0 + b1) - z0 - z1;
-
-    BigNumber result;
-    result.digits = std::vector<char>(2 * m + z1.digits.size(), 0);
-    for (size_t i = 0; i < z1.digits.size(); ++i)
-        result.digits[i + 2 * m] = z1.digits[i];
-
-    for (size_t i = 0; i < z2.digits.size(); ++i) {
-        if (i + m >= result.digits.size())
-            result.digits.resize(i + m + 1, 0);
-        result.digits[i + m] += z2.digits[i];
-    }
-
-    for (size_t i = 0; i < z0.digits.size(); ++i) {
-        if (i >= result.digits.size())
-            result.digits.resize(i + 1, 0);
-        result.digits[i] += z0.digits[i];
-    }
-
-    int carry = 0;
-    for (size_t i = 0; i < result.digits.size(); ++i) {
-        int sum = result.digits[i] + carry;
-        result.digits[i] = sum % 10;
-        carry = sum / 10;
+    BigNumber sumA = a0 + a1;
+    BigNumber sumB = b0 + b1;
+    const BigNumber* lhs[3] = {&a0, &a1, &sumA};
+    const BigNumber* rhs[3] = {&b0, &b1, &sumB};
+    BigNumber products[3];
+    multiplyProducts(lhs, rhs, products, 3, n);
+
+    // z0 + (P - z0 - z2) * 10^m + z2 * 10^2m 在一个 int64 累加器里一遍完成，最后统一进位
+    const DigitVector& z0 = products[0].digits;
+    const DigitVector& z2 = products[1].digits;
+    const DigitVector& p = products[2].digits;
+    std::vector<int64_t> acc(std::max({z0.size(), m + p.size(), 2 * m + z2.size()}), 0);
+    for (size_t i = 0; i < p.size(); ++i) {
+        acc[m + i] += p[i] - (i < z0.size() ? z0[i] : 0) - (i < z2.size() ? z2[i] : 0);
     }
-    if (carry) result.digits.push_back(carry);
-
-    result.removeLeadingZeros();
-    return result;
+    for (size_t i = 0; i < z0.size(); ++i) acc[i] += z0[i];
+    for (size_t i = 0; i < z2.size(); ++i) acc[2 * m + i] += z2[i];
+    return fromCoefficients(acc.data(), acc.size());
 }
\ No newline at end of file
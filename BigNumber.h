@@ -4,6 +4,13 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <utility>
+#include "BigNumberArena.h"
+#include "MultiplyThresholds.h"
+
+struct BarrettReducer;
+class TaskPool;
 
 class BigNumber {
 public:
@@ -26,13 +33,61 @@ public:
     void rightShift1();
     BigNumber rightShiftDecimal(int n) const;
 
+    // 二进制位运算，均作用于绝对值。数字按十进制存储，除 testBit(0)（直接看个位奇偶）外每次调用都要
+    // 做一次 O(n^2) 的进制转换；循环里逐位访问时应先 toBinaryWords 一次再在字数组上操作
+    int bitLength() const;
+    bool testBit(int i) const;
+    void setBit(int i);
+    BigNumber operator<<(int bits) const;
+    BigNumber operator>>(int bits) const;
+    BigNumber operator&(const BigNumber& other) const;
+    BigNumber operator|(const BigNumber& other) const;
+
+    // 与 32 位字数组（低位在前）互相转换；fromRandomBits 取缓冲区的低 bits 位
+    std::vector<uint32_t> toBinaryWords() const;
+    static BigNumber fromBinaryWords(const std::vector<uint32_t>& words);
+    static BigNumber fromRandomBits(const std::vector<uint32_t>& buffer, int bits);
+
     BigNumber powmod(const BigNumber& exponent, const BigNumber& mod) const;
+    BigNumber powmod(const BigNumber& exponent, const BarrettReducer& reducer) const;
+    // 指数已是二进制字（低位在前）时直接使用，省去每次的十进制到二进制转换
+    BigNumber powmodWords(const std::vector<uint32_t>& exponent, const BarrettReducer& reducer) const;
+    // 同一模数下的幂乘积 b1^e1 * b2^e2 * ... mod m：Straus 交错定长窗口，所有底数共用一条平方链
+    static BigNumber multiPowmod(const std::vector<std::pair<BigNumber, BigNumber>>& terms, const BigNumber& mod);
+    static BigNumber multiPowmod(const std::vector<std::pair<BigNumber, BigNumber>>& terms, const BarrettReducer& reducer);
     BigNumber modinv(const BigNumber& mod) const;
+    uint32_t modWord(uint32_t m) const;
 
     std::string toString() const;
+    size_t hash() const;
+
+    // 乘法算法切换阈值（十进制位数），karatsuba 和 ntt 的默认值来自 calibrate_mul 生成的 MultiplyThresholds.h。
+    // 实测 NTT 在 Toom-3 开始胜过 Karatsuba 之前就已经快得多，所以 Toom-3 默认不参与阈值分派，
+    // 只用来把超出 NTT 最大变换长度的乘法三等分；关闭 NTT 后可以把 toom3 设为有限值启用它
+    struct MultiplyThresholds {
+        size_t karatsuba = KARATSUBA_THRESHOLD;
+        size_t toom3 = static_cast<size_t>(-1);
+        size_t ntt = NTT_THRESHOLD;
+    };
+    static MultiplyThresholds multiplyThresholds;
+
+    enum class MultiplyAlgorithm { Schoolbook, Karatsuba, Toom3, Ntt, Unbalanced };
+    // 两个长度分别为 aDigits、bDigits 的操作数在顶层会走哪种算法
+    static MultiplyAlgorithm multiplyAlgorithm(size_t aDigits, size_t bDigits);
+
+    // 大乘法的子乘积分派到 TaskPool 并行计算：操作数不少于 minDigits 位且递归深度小于 maxDepth 时才分派。
+    // minDigits 为 0 时由 multiplyThresholds 推出，落在 Karatsuba 区间内；pool 为空时使用 TaskPool::shared()
+    struct ParallelMultiply {
+        size_t minDigits = 0;
+        int maxDepth = 2;
+        TaskPool* pool = nullptr;
+    };
+    static ParallelMultiply parallelMultiply;
 
 private:
-    std::vector<char> digits;
+    using DigitVector = std::vector<char, ArenaAllocator<char>>;
+
+    DigitVector digits;
     bool isNegative;
 
     void removeLeadingZeros();
@@ -42,23 +97,29 @@ private:
     static BigNumber absSubtract(const BigNumber& a, const BigNumber& b);
     static BigNumber divide(const BigNumber& dividend, const BigNumber& divisor, BigNumber& remainder);
     static BigNumber absMultiply(const BigNumber& a, const BigNumber& b);
+    static BigNumber schoolbookMultiply(const BigNumber& a, const BigNumber& b);
+    static BigNumber unbalancedMultiply(const BigNumber& a, const BigNumber& b);
+    static BigNumber karatsubaMultiply(const BigNumber& a, const BigNumber& b);
+    static BigNumber fromCoefficients(const int64_t* coefficients, size_t count);
+    static BigNumber toom3Multiply(const BigNumber& a, const BigNumber& b);
+    static BigNumber nttMultiply(const BigNumber& a, const BigNumber& b);
+    std::vector<uint32_t> toNttLimbs() const;
+    static BigNumber divideSmall(const BigNumber& a, int divisor);
+    static void multiplyProducts(const BigNumber* const lhs[], const BigNumber* const rhs[], BigNumber out[], size_t count, size_t digits);
 };
 
 struct BarrettReducer {
     BigNumber modulus;
     BigNumber mu;
+    int k;
 
     BarrettReducer(const BigNumber& m) : modulus(m) {
-        int k = m.toString().length();
-        BigNumber b2k("1");
-        for (int i = 0; i < 2 * k; ++i) {
-            b2k = b2k * BigNumber(10);
-        }
-        mu = b2k / modulus;
+        k = m.toString().length();
+        mu = BigNumber(1).shiftLeft(2 * k) / modulus;
     }
 
     BigNumber reduce(const BigNumber& x) const {
-        int k = modulus.toString().length();
+        ArenaScope scope;
         int shift1 = k - 1;
         int shift2 = k + 1;
 
@@ -71,7 +132,7 @@ struct BarrettReducer {
         while (r < BigNumber(0)) r = r + modulus;
         while (r >= modulus) r = r - modulus;
 
-        return r;
+        return scope.detach(r);
     }
 };
 #endif // BIGNUMBER_H
@@ -0,0 +1,59 @@
+#include "BigNumberArena.h"
+#include <algorithm>
+
+namespace {
+const size_t kInitialChunkSize = 256 * 1024;
+const size_t kMaxRetainedSize = 16 * 1024 * 1024;
+const size_t kAlignment = alignof(std::max_align_t);
+}
+
+thread_local int BigNumberArena::scopeDepth = 0;
+
+BigNumberArena& BigNumberArena::local() {
+    thread_local BigNumberArena arena;
+    return arena;
+}
+
+void* BigNumberArena::allocate(size_t size) {
+    if (scopeDepth == 0 || suspended) return nullptr;
+
+    size = (size + kAlignment - 1) & ~(kAlignment - 1);
+    while (current < chunks.size()) {
+        Chunk& chunk = chunks[current];
+        if (offset + size <= chunk.size) {
+            void* p = chunk.data.get() + offset;
+            offset += size;
+            return p;
+        }
+        ++current;
+        offset = 0;
+    }
+
+    size_t chunkSize = chunks.empty() ? kInitialChunkSize : chunks.back().size * 2;
+    while (chunkSize < size) chunkSize *= 2;
+    chunks.push_back(Chunk{std::unique_ptr<char[]>(new char[chunkSize]), chunkSize});
+    current = chunks.size() - 1;
+    offset = size;
+    return chunks.back().data.get();
+}
+
+bool BigNumberArena::owns(const void* p) const {
+    const char* c = static_cast<const char*>(p);
+    for (const auto& chunk : chunks) {
+        if (c >= chunk.data.get() && c < chunk.data.get() + chunk.size) return true;
+    }
+    return false;
+}
+
+// 一轮用到多个块时合并成一个足够大的块，下一轮就只在单个预分配区域内线性分配
+void BigNumberArena::reset() {
+    if (chunks.size() > 1) {
+        size_t total = 0;
+        for (const auto& chunk : chunks) total += chunk.size;
+        total = std::min(total, kMaxRetainedSize);
+        chunks.clear();
+        chunks.push_back(Chunk{std::unique_ptr<char[]>(new char[total]), total});
+    }
+    current = 0;
+    offset = 0;
+}
@@ -0,0 +1,112 @@
+#ifndef BIGNUMBER_ARENA_H
+#define BIGNUMBER_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// 线程私有的线性分配区：ArenaScope 存活期间 BigNumber 的临时数字缓冲从这里分配，
+// 作用域结束时整体退回到进入时的位置。arena 中的内存不能离开所在线程，也不能被作用域外的对象持有，
+// 需要带出作用域的结果必须经过 ArenaScope::detach 拷贝到堆上。
+class BigNumberArena {
+public:
+    static BigNumberArena& local();
+
+    void* allocate(size_t size);
+    bool owns(const void* p) const;
+
+    // 当前线程打开的 ArenaScope 层数。它是平凡析构的 thread_local，线程退出或进程退出时
+    // arena 对象本身已析构后仍可读取；为 0 时线程上不存在 arena 分配的对象
+    static int activeScopes() { return scopeDepth; }
+
+private:
+    friend class ArenaScope;
+    friend class ArenaSuspend;
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t current = 0;
+    size_t offset = 0;
+    bool suspended = false;
+    static thread_local int scopeDepth;
+
+    void reset();
+};
+
+class ArenaScope {
+public:
+    ArenaScope() : arena(BigNumberArena::local()), chunk(arena.current), offset(arena.offset) { ++BigNumberArena::scopeDepth; }
+    ~ArenaScope() {
+        if (--BigNumberArena::scopeDepth == 0) {
+            arena.reset();
+        } else {
+            arena.current = chunk;
+            arena.offset = offset;
+        }
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    // 把作用域内算出的结果拷贝到堆上，作用域结束后仍可安全使用
+    template <typename T>
+    T detach(const T& value) {
+        bool suspended = arena.suspended;
+        arena.suspended = true;
+        T copy(value);
+        arena.suspended = suspended;
+        return copy;
+    }
+
+private:
+    BigNumberArena& arena;
+    size_t chunk;
+    size_t offset;
+};
+
+// 暂时关闭当前线程的 arena，期间分配的对象可以交给其他线程持有和释放
+class ArenaSuspend {
+public:
+    ArenaSuspend() : arena(BigNumberArena::local()), previous(arena.suspended) { arena.suspended = true; }
+    ~ArenaSuspend() { arena.suspended = previous; }
+
+    ArenaSuspend(const ArenaSuspend&) = delete;
+    ArenaSuspend& operator=(const ArenaSuspend&) = delete;
+
+private:
+    BigNumberArena& arena;
+    bool previous;
+};
+
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (BigNumberArena::activeScopes() > 0) {
+            if (void* p = BigNumberArena::local().allocate(n * sizeof(T))) return static_cast<T*>(p);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    // 没有打开的作用域时不去访问 arena：静态 BigNumber 在退出时析构，此时线程的 arena 可能已经销毁
+    void deallocate(T* p, size_t) noexcept {
+        if (BigNumberArena::activeScopes() == 0 || !BigNumberArena::local().owns(p)) ::operator delete(p);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) { return false; }
+
+#endif // BIGNUMBER_ARENA_H
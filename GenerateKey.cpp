@@ -1,6 +1,8 @@
 #include "GenerateKey.h"
-#include <random>
-#include <ctime>
+#include "RandomSource.h"
+#include "TaskPool.h"
+#include <cmath>
+#include <string>
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -9,13 +11,19 @@ std::mutex prime_mutex;
 std::atomic<bool> found_p(false), found_q(false);
 BigNumber global_p, global_q;
 
+// 放在文件作用域，保证在任何 ArenaScope 之外构造
+static const BigNumber ONE(1);
+static const BigNumber TWO(2);
+static const BigNumber THREE(3);
+
 void generatePrimeCandidate(int bits, BigNumber& result, std::atomic<bool>& foundFlag) {
     while (!foundFlag.load()) {
+        ArenaScope scope;
         BigNumber candidate = generateRandomOddBigNumber(bits / 2);
-        if (isProbablyPrime(candidate)) {
+        if (isProbablyPrime_bpsw(candidate)) {
             std::lock_guard<std::mutex> lock(prime_mutex);
             if (!foundFlag.load()) {
-                result = candidate;
+                result = scope.detach(candidate);
                 foundFlag.store(true);
             }
             return;
@@ -23,62 +31,68 @@ void generatePrimeCandidate(int bits, BigNumber& result, std::atomic<bool>& foun
     }
 }
 
+// 最低位置 1 保证为奇数；最高两位置 1 保证恰好 bits 位，且两个 bits 位素数之积恰好 2 * bits 位。
+// 三个及以上素数时 0.75 * 2^bits 的下界不够，乘积可能少一位，见 primeLowerBound
+static BigNumber oddNumberFromWords(std::vector<uint32_t>& words, int bits) {
+    words[0] |= 1;
+    words[(bits - 1) / 32] |= uint32_t(1) << ((bits - 1) % 32);
+    words[(bits - 2) / 32] |= uint32_t(1) << ((bits - 2) % 32);
+    return BigNumber::fromRandomBits(words, bits);
+}
+
 BigNumber generateRandomOddBigNumber(int bits) {
     if (bits < 2) throw std::invalid_argument("Bit length must be at least 2");
 
-    int digits = bits / 3.32 + 1;
-    std::string numStr;
-    static std::mt19937 gen(time(0));
-    std::uniform_int_distribution<> dist(0, 9);
+    std::vector<uint32_t> words((bits + 31) / 32);
+    RandomSource::local().fill(words);
 
-    numStr += '1' + dist(gen) % 9;
-    for (int i = 1; i < digits - 1; ++i)
-        numStr += '0' + dist(gen);
-
-    static const char odds[] = {'1', '3', '5', '7', '9'};
-    numStr += odds[dist(gen) % 5];
-
-    return BigNumber(numStr);
+    return oddNumberFromWords(words, bits);
 }
 
 BigNumber generateRandomOddBigNumber_optimization(int bits) {
     if (bits < 2) throw std::invalid_argument("Bit length must be at least 2");
 
-    static std::mt19937_64 gen(std::random_device{}());
-    std::vector<char> binaryDigits;
+    // 每个线程复用自己的缓冲区，候选数的随机位一次整块拷入
+    thread_local std::vector<uint32_t> words;
+    words.resize((bits + 31) / 32);
+    RandomSource::local().fill(words);
 
-    binaryDigits.reserve(bits);
-    binaryDigits.push_back(1);
+    return oddNumberFromWords(words, bits);
+}
 
-    std::uniform_int_distribution<> dist(0, 1);
-    for (int i = 1; i < bits - 1; ++i) {
-        binaryDigits.push_back(dist(gen));
+// 把正整数 m 拆成 d * 2^s，返回 s，d 的二进制字留在 words 里。BigNumber 按十进制存储，
+// 每次 testBit / >> 都要整体转换一遍，所以这里只转换一次，在同一个字数组上数末尾零位并右移
+static int splitPowerOfTwo(const BigNumber& m, std::vector<uint32_t>& words) {
+    words = m.toBinaryWords();
+    size_t zeroWords = 0;
+    while (words[zeroWords] == 0) ++zeroWords;
+    int shift = __builtin_ctz(words[zeroWords]);
+    words.erase(words.begin(), words.begin() + zeroWords);
+    if (shift) {
+        for (size_t i = 0; i < words.size(); ++i) {
+            uint32_t high = i + 1 < words.size() ? words[i + 1] << (32 - shift) : 0;
+            words[i] = (words[i] >> shift) | high;
+        }
     }
+    while (words.size() > 1 && words.back() == 0) words.pop_back();
+    return static_cast<int>(zeroWords * 32) + shift;
+}
 
-    binaryDigits.push_back(1);
-    BigNumber result(0);
-    BigNumber two(2);
-
-    for (char bit : binaryDigits) {
-        result = result * two + BigNumber(bit);
-    }
-    return result;
+static int wordsBitLength(const std::vector<uint32_t>& words) {
+    return static_cast<int>(words.size() - 1) * 32 + (32 - __builtin_clz(words.back()));
 }
 
 bool isProbablyPrime(const BigNumber& n, int k) {
     if (n == BigNumber(2) || n == BigNumber(3)) return true;
-    if (n < BigNumber(2) || (n % BigNumber(2) == BigNumber(0))) return false;
+    if (n < BigNumber(2) || !n.testBit(0)) return false;
 
-    BigNumber d = n - BigNumber(1);
-    int r = 0;
-    while (d % BigNumber(2) == BigNumber(0)) {
-        d = d / BigNumber(2);
-        r++;
-    }
-    static std::mt19937 gen(time(0));
-    std::uniform_int_distribution<int> dist(2, 9);
+    std::vector<uint32_t> words;
+    int r = splitPowerOfTwo(n - BigNumber(1), words);
+    BigNumber d = BigNumber::fromBinaryWords(words);
     for (int i = 0; i < k; ++i) {
-        BigNumber a = BigNumber(dist(gen)) % (n - BigNumber(4)) + BigNumber(2);
+        ArenaScope scope;
+        int base = 2 + static_cast<int>(RandomSource::local().uniform(8));
+        BigNumber a = BigNumber(base) % (n - BigNumber(4)) + BigNumber(2);
         BigNumber x = a.powmod(d, n);
         if (x == BigNumber(1) || x == n - BigNumber(1)) continue;
         bool passed = false;
@@ -95,51 +109,195 @@ bool isProbablyPrime(const BigNumber& n, int k) {
     return true;
 }
 
-bool isProbablyPrime_optimization(const BigNumber& n, int k) {
-    static const BigNumber ONE(1);
-    static const BigNumber TWO(2);
-    static const BigNumber THREE(3);
-
-    if (n == TWO || n == THREE) return true;
-    if (n < TWO || (n % TWO == BigNumber(0))) return false;
+static const int smallPrimes[] = {
+    3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
+    37, 41, 43, 47, 53, 59, 61, 67, 71, 73,
+    79, 83, 89, 97, 101, 103, 107, 109, 113, 127
+};
 
-    static const int smallPrimes[] = {
-        3, 5, 7, 11, 13, 17, 19, 23, 29, 31,
-        37, 41, 43, 47, 53, 59, 61, 67, 71, 73,
-        79, 83, 89, 97, 101, 103, 107, 109, 113, 127
-    };
+// 返回 1 表示 n 就是小素数，0 表示被小素数整除，-1 表示需要继续检测
+static int trialDivide(const BigNumber& n) {
     for (int p : smallPrimes) {
-        BigNumber prime(p);
-        if (n == prime) return true;
-        if (n % prime == BigNumber(0)) return false;
+        if (n == BigNumber(p)) return 1;
+        if (n.modWord(p) == 0) return 0;
     }
+    return -1;
+}
 
-    BigNumber d = n - ONE;
-    int r = 0;
-    while (d % TWO == BigNumber(0)) {
-        d = d / TWO;
-        ++r;
+// 以 a 为底的一轮强概率素数检测，n - 1 = d * 2^r
+static bool millerRabinRound(const BigNumber& a, const BigNumber& d, int r, const BigNumber& n, const BarrettReducer& reducer) {
+    ArenaScope scope;
+    BigNumber nMinusOne = n - ONE;
+    BigNumber x = a.powmod(d, reducer);
+    if (x == ONE || x == nMinusOne) return true;
+    for (int j = 0; j < r - 1; ++j) {
+        x = reducer.reduce(x * x);
+        if (x == nMinusOne) return true;
     }
+    return false;
+}
+
+bool isProbablyPrime_optimization(const BigNumber& n, int k) {
+    if (n == TWO || n == THREE) return true;
+    if (n < TWO || !n.testBit(0)) return false;
+
+    int small = trialDivide(n);
+    if (small >= 0) return small == 1;
 
+    std::vector<uint32_t> dWords;
+    int r = splitPowerOfTwo(n - ONE, dWords);
+    BigNumber d = BigNumber::fromBinaryWords(dWords);
+
+    // 第一轮固定以 2 为底，绝大多数合数在这里就被淘汰，不必准备随机底数
     BarrettReducer reducer(n);
-    thread_local std::mt19937 gen(std::random_device{}());
-    std::uniform_int_distribution<int> dist(2, 1 << 16);
+    if (!millerRabinRound(TWO, d, r, n, reducer)) return false;
+
+    // 其余底数在 [2, 2^(L-2) + 1] 内均匀选取（L 为 n 的位数），保证不超过 n - 2。n 为奇数，n - 1 与 n 位数相同
+    int bits = r + wordsBitLength(dWords);
+    std::vector<uint32_t> words((bits + 29) / 32);
+    for (int i = 1; i < k; ++i) {
+        ArenaScope scope;
+        RandomSource::local().fill(words);
+        BigNumber a = BigNumber::fromRandomBits(words, bits - 2) + TWO;
+        if (!millerRabinRound(a, d, r, n, reducer)) return false;
+    }
+    return true;
+}
 
-    for (int i = 0; i < k; ++i) {
-        BigNumber a = BigNumber(dist(gen)) % (n - BigNumber(4)) + TWO;
-        BigNumber x = a.powmod(d, n);
-        if (x == ONE || x == n - ONE) continue;
-        bool passed = false;
-        for (int j = 0; j < r - 1; ++j) {
-            x = x.powmod(TWO, n);
-            if (x == n - ONE) {
-                passed = true;
-                break;
-            }
+// 小整数 a 对奇数 n 的 Jacobi 符号：先用二次互反律把 n 换到下面，之后全部是机器整数运算
+static int jacobiSymbol(int64_t a, const BigNumber& n) {
+    int result = 1;
+    if (a < 0) {
+        a = -a;
+        if (n.modWord(4) == 3) result = -result;
+    }
+    while (a != 0 && a % 2 == 0) {
+        a /= 2;
+        uint32_t r8 = n.modWord(8);
+        if (r8 == 3 || r8 == 5) result = -result;
+    }
+    if (a == 0) return 0;
+    if (a == 1) return result;
+
+    if (a % 4 == 3 && n.modWord(4) == 3) result = -result;
+    uint64_t x = n.modWord(static_cast<uint32_t>(a));
+    uint64_t y = static_cast<uint64_t>(a);
+    while (x != 0) {
+        while (x % 2 == 0) {
+            x /= 2;
+            if (y % 8 == 3 || y % 8 == 5) result = -result;
         }
-        if (!passed) return false;
+        std::swap(x, y);
+        if (x % 4 == 3 && y % 4 == 3) result = -result;
+        x %= y;
     }
-    return true;
+    return y == 1 ? result : 0;
+}
+
+static bool isPerfectSquare(const BigNumber& n) {
+    BigNumber x = BigNumber(1) << ((n.bitLength() + 1) / 2);
+    while (true) {
+        BigNumber y = x + n / x;
+        y.rightShift1();
+        if (y >= x) break;
+        x = y;
+    }
+    return x * x == n;
+}
+
+static BigNumber modSigned(int64_t value, const BigNumber& n) {
+    BigNumber v(static_cast<int>(value < 0 ? -value : value));
+    v = v % n;
+    if (value < 0 && v != BigNumber(0)) v = n - v;
+    return v;
+}
+
+static BigNumber subMod(const BigNumber& a, const BigNumber& b, const BigNumber& n) {
+    BigNumber r = a - b;
+    if (r < BigNumber(0)) r = r + n;
+    return r;
+}
+
+static BigNumber addMod(const BigNumber& a, const BigNumber& b, const BigNumber& n) {
+    BigNumber r = a + b;
+    if (r >= n) r = r - n;
+    return r;
+}
+
+// 要求 x < 2n：奇数先加 n 再减半，结果小于 1.5n，至多再减一次 n
+static BigNumber halveMod(BigNumber x, const BigNumber& n) {
+    if (x.testBit(0)) x = x + n;
+    x.rightShift1();
+    if (x >= n) x = x - n;
+    return x;
+}
+
+// x * c mod n，c 为小整数：乘积只比 n 多几位，Barrett 约简的商也只有几位，远比乘以 c mod n（负数时与 n 同长）便宜
+static BigNumber mulSmall(const BigNumber& x, int64_t c, const BigNumber& n, const BarrettReducer& reducer) {
+    BigNumber r = reducer.reduce(x * BigNumber(static_cast<int>(c < 0 ? -c : c)));
+    if (c < 0 && r != BigNumber(0)) r = n - r;
+    return r;
+}
+
+// Selfridge 方法 A 选取 D，P = 1，Q = (1 - D) / 4 的强 Lucas 概率素数检测
+static bool strongLucasTest(const BigNumber& n, const BarrettReducer& reducer) {
+    int64_t D = 5;
+    for (int attempts = 0;; ++attempts) {
+        int j = jacobiSymbol(D, n);
+        if (j == -1) break;
+        if (j == 0 && n != BigNumber(static_cast<int>(D < 0 ? -D : D))) return false;
+        if (attempts == 10 && isPerfectSquare(n)) return false;
+        D = D > 0 ? -(D + 2) : -D + 2;
+    }
+    int64_t Q = (1 - D) / 4;
+
+    BigNumber Qm = modSigned(Q, n);
+
+    std::vector<uint32_t> bits;
+    int s = splitPowerOfTwo(n + ONE, bits);
+
+    // D = 5 时 Q = -1，Q^k 只会是 ±1，平方恒为 1，省掉一次全长乘法
+    bool unitQ = Q == -1;
+
+    // 只有 U * V、V^2、Q^k 的平方是全长乘法；乘 D、Q 用小整数乘法，加倍、相加和减半的结果不超过 2n，用一次条件减法即可
+    BigNumber U(1), V(1), Qk = Qm;
+    for (int i = wordsBitLength(bits) - 2; i >= 0; --i) {
+        ArenaScope scope;
+        U = reducer.reduce(U * V);
+        V = scope.detach(subMod(reducer.reduce(V * V), addMod(Qk, Qk, n), n));
+        Qk = unitQ ? scope.detach(ONE) : reducer.reduce(Qk * Qk);
+        if ((bits[i / 32] >> (i % 32)) & 1) {
+            BigNumber nextU = halveMod(U + V, n);
+            BigNumber nextV = halveMod(mulSmall(U, D, n, reducer) + V, n);
+            U = scope.detach(nextU);
+            V = scope.detach(nextV);
+            Qk = scope.detach(mulSmall(Qk, Q, n, reducer));
+        }
+    }
+
+    if (U == BigNumber(0) || V == BigNumber(0)) return true;
+    for (int r = 1; r < s; ++r) {
+        V = subMod(reducer.reduce(V * V), addMod(Qk, Qk, n), n);
+        if (V == BigNumber(0)) return true;
+        Qk = unitQ ? ONE : reducer.reduce(Qk * Qk);
+    }
+    return false;
+}
+
+bool isProbablyPrime_bpsw(const BigNumber& n) {
+    if (n == TWO || n == THREE) return true;
+    if (n < TWO || !n.testBit(0)) return false;
+
+    int small = trialDivide(n);
+    if (small >= 0) return small == 1;
+
+    std::vector<uint32_t> words;
+    int r = splitPowerOfTwo(n - ONE, words);
+    BigNumber d = BigNumber::fromBinaryWords(words);
+
+    BarrettReducer reducer(n);
+    if (!millerRabinRound(TWO, d, r, n, reducer)) return false;
+    return strongLucasTest(n, reducer);
 }
 
 void generateRSAKeyPair(int bits, BigNumber& e, BigNumber& d, BigNumber& n) {
@@ -187,4 +345,121 @@ void generateRSAKeyPair_optimization(int bits, BigNumber& e, BigNumber& d, BigNu
     }
 
     d = e.modinv(phi);
-}
\ No newline at end of file
+}
+// u 个素数中 b 位的那个不小于 2^(b - 1/u)，则乘积至少 2^(bits - 1)，n 恰好 bits 位。
+// 取 2^(32 - 1/u) 向上取整后再移位，只会比精确下界略大
+static BigNumber primeLowerBound(int primeBits, int primeCount) {
+    uint64_t top = static_cast<uint64_t>(std::ceil(std::ldexp(std::pow(2.0, -1.0 / primeCount), 32))) + 1;
+    if (primeBits < 32) return BigNumber(std::to_string((top >> (32 - primeBits)) + 1));
+    return BigNumber(std::to_string(top)) << (primeBits - 32);
+}
+
+void generateRSAKeyPair_multiPrime(int bits, int primeCount, RSAPrivateKeyCRT& key) {
+    if (primeCount < 2 || primeCount > 4)
+        throw std::invalid_argument("Prime count must be between 2 and 4");
+
+    key.e = BigNumber(65537);
+    key.primes.assign(primeCount, BigNumber(0));
+
+    std::vector<int> primeBits(primeCount);
+    std::vector<BigNumber> lowerBounds;
+    for (int i = 0; i < primeCount; ++i) {
+        primeBits[i] = bits / primeCount + (i < bits % primeCount ? 1 : 0);
+        lowerBounds.push_back(primeLowerBound(primeBits[i], primeCount));
+    }
+
+    auto findPrime = [&key, &lowerBounds](int primeBits, int index) {
+        while (true) {
+            ArenaScope scope;
+            BigNumber candidate = generateRandomOddBigNumber_optimization(primeBits);
+            if (candidate < lowerBounds[index]) continue;
+            if ((candidate - BigNumber(1)) % key.e == BigNumber(0)) continue;
+            if (isProbablyPrime_bpsw(candidate)) {
+                key.primes[index] = scope.detach(candidate);
+                return;
+            }
+        }
+    };
+
+    std::vector<std::function<void()>> searches;
+    for (int i = 0; i < primeCount; ++i)
+        searches.push_back([&findPrime, &primeBits, i]() { findPrime(primeBits[i], i); });
+    TaskPool::shared().run(searches);
+
+    for (int i = 1; i < primeCount; ++i) {
+        for (int j = 0; j < i; ++j) {
+            if (key.primes[i] == key.primes[j]) {
+                findPrime(primeBits[i], i);
+                j = -1;
+            }
+        }
+    }
+
+    key.n = BigNumber(1);
+    BigNumber phi(1);
+    for (const auto& r : key.primes) {
+        key.n = key.n * r;
+        phi = phi * (r - BigNumber(1));
+    }
+    key.d = key.e.modinv(phi);
+
+    key.exponents.clear();
+    key.coefficients.clear();
+    key.reducers.clear();
+    for (const auto& r : key.primes) key.reducers.emplace_back(r);
+    BigNumber product(1);
+    for (int i = 0; i < primeCount; ++i) {
+        const BigNumber& r = key.primes[i];
+        key.exponents.push_back(key.d % (r - BigNumber(1)));
+        key.coefficients.push_back(i == 0 ? BigNumber(0) : (product % r).modinv(r));
+        product = product * r;
+    }
+}
+
+void generateRSABatchKeySet(int bits, int keyCount, RSABatchKeySet& keys) {
+    if (keyCount < 1 || keyCount > 16)
+        throw std::invalid_argument("Key count must be between 1 and 16");
+
+    std::vector<uint32_t> small;
+    for (uint32_t candidate = 3; small.size() < static_cast<size_t>(keyCount); candidate += 2) {
+        bool prime = true;
+        for (uint32_t f : small) prime = prime && candidate % f != 0;
+        if (prime) small.push_back(candidate);
+    }
+
+    // 每个 e_i 都必须与 phi 互素，即 e_i 不整除 p - 1 和 q - 1
+    keys.primes.assign(2, BigNumber(0));
+    auto findPrime = [&keys, &small](int primeBits, int index) {
+        while (true) {
+            ArenaScope scope;
+            BigNumber candidate = generateRandomOddBigNumber_optimization(primeBits);
+            bool usable = true;
+            for (uint32_t e : small) usable = usable && candidate.modWord(e) != 1;
+            if (usable && isProbablyPrime_bpsw(candidate)) {
+                keys.primes[index] = scope.detach(candidate);
+                return;
+            }
+        }
+    };
+
+    std::vector<std::function<void()>> searches = {
+        [&findPrime, bits]() { findPrime(bits - bits / 2, 1); },
+        [&findPrime, bits]() { findPrime(bits / 2, 0); },
+    };
+    TaskPool::shared().run(searches);
+    while (keys.primes[0] == keys.primes[1]) findPrime(bits / 2, 0);
+
+    const BigNumber& p = keys.primes[0];
+    const BigNumber& q = keys.primes[1];
+    keys.n = p * q;
+    keys.phi = (p - BigNumber(1)) * (q - BigNumber(1));
+    keys.coefficients = {BigNumber(0), (p % q).modinv(q)};
+    keys.reducers = {BarrettReducer(p), BarrettReducer(q)};
+
+    keys.exponents.clear();
+    keys.privateExponents.clear();
+    for (uint32_t e : small) {
+        keys.exponents.push_back(BigNumber(static_cast<int>(e)));
+        keys.privateExponents.push_back(keys.exponents.back().modinv(keys.phi));
+    }
+}
@@ -2,12 +2,40 @@
 #define GENERATE_KEY_H
 
 #include "BigNumber.h"
+#include <vector>
+
+// 多素数 RSA 私钥（RFC 8017 风格），primes 依次为 r_1..r_u
+struct RSAPrivateKeyCRT {
+    BigNumber n;
+    BigNumber e;
+    BigNumber d;
+    std::vector<BigNumber> primes;       // r_i
+    std::vector<BigNumber> exponents;    // d_i = d mod (r_i - 1)
+    std::vector<BigNumber> coefficients; // t_i = (r_1 * ... * r_{i-1})^-1 mod r_i，t_1 不使用
+    // r_i 的 Barrett 参数随私钥保存，不放进进程共享的 ModulusCache；为空时 rsaPrivateCRT 现场构造
+    std::vector<BarrettReducer> reducers;
+};
+
+// Fiat 批量 RSA 密钥组：共享模数 n，公钥指数依次为互不相同的小素数 3, 5, 7, 11, ...
+struct RSABatchKeySet {
+    BigNumber n;
+    BigNumber phi;
+    std::vector<BigNumber> primes;           // p, q
+    std::vector<BigNumber> coefficients;     // 同 RSAPrivateKeyCRT，t_2 = p^-1 mod q
+    std::vector<BigNumber> exponents;        // e_i
+    std::vector<BigNumber> privateExponents; // d_i = e_i^-1 mod phi
+    std::vector<BarrettReducer> reducers;    // 同 RSAPrivateKeyCRT
+};
 
 BigNumber generateRandomOddBigNumber(int bits);
 BigNumber generateRandomOddBigNumber_optimization(int bits);
 bool isProbablyPrime(const BigNumber& n, int k = 3);
 bool isProbablyPrime_optimization(const BigNumber& n, int k = 5);
+// Baillie-PSW：一轮以 2 为底的强概率素数检测加一轮强 Lucas 检测
+bool isProbablyPrime_bpsw(const BigNumber& n);
 void generateRSAKeyPair(int bits, BigNumber& e, BigNumber& d, BigNumber& n);
 void generateRSAKeyPair_optimization(int bits, BigNumber& e, BigNumber& d, BigNumber& n);
+void generateRSAKeyPair_multiPrime(int bits, int primeCount, RSAPrivateKeyCRT& key);
+void generateRSABatchKeySet(int bits, int keyCount, RSABatchKeySet& keys);
 
 #endif // GENERATE_KEY_H
@@ -0,0 +1,110 @@
+#include "ModulusCache.h"
+#include <algorithm>
+
+ModulusContext::ModulusContext(const BigNumber& modulus)
+    : reducer(modulus), bitLength(modulus.bitLength()) {
+    // 模数、mu 的数字各占一字节，每个缓存指数不超过模数的二进制字数
+    size_t digits = reducer.modulus.toString().length();
+    size_t words = bitLength / 32 + 1;
+    bytes = sizeof(ModulusContext) + 2 * digits + kMaxExponents * (digits + words * sizeof(uint32_t) + sizeof(CachedExponent));
+}
+
+std::vector<uint32_t> ModulusContext::publicExponentWords(const BigNumber& exponent) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = exponents.begin(); it != exponents.end(); ++it) {
+        if (it->exponent == exponent) {
+            std::rotate(it, it + 1, exponents.end());
+            return exponents.back().words;
+        }
+    }
+
+    ArenaSuspend suspend;
+    if (exponents.size() == kMaxExponents) exponents.erase(exponents.begin());
+    exponents.push_back(CachedExponent{exponent, exponent.toBinaryWords()});
+    return exponents.back().words;
+}
+
+BigNumber ModulusContext::powmod(const BigNumber& base, const BigNumber& exponent) const {
+    return base.powmodWords(exponent.toBinaryWords(), reducer);
+}
+
+ModulusCache::ModulusCache(size_t budgetBytes, size_t shardCount) {
+    shardCount = std::max<size_t>(1, shardCount);
+    for (size_t i = 0; i < shardCount; ++i) shards.emplace_back(new Shard);
+    shardBudget = budgetBytes / shardCount;
+}
+
+ModulusCache& ModulusCache::shared() {
+    static ModulusCache cache;
+    return cache;
+}
+
+std::shared_ptr<const ModulusContext> ModulusCache::get(const BigNumber& modulus) {
+    size_t h = modulus.hash();
+    Shard& shard = *shards[h % shards.size()];
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(h);
+        if (found != shard.index.end() && found->second->context->modulus() == modulus) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+            ++hits;
+            return found->second->context;
+        }
+    }
+
+    // 在锁外构造，mu 的除法较慢；缓存里的数字必须分配在堆上
+    ++misses;
+    std::shared_ptr<const ModulusContext> context;
+    {
+        ArenaSuspend suspend;
+        context = std::make_shared<const ModulusContext>(modulus);
+    }
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(h);
+    if (found != shard.index.end()) {
+        if (found->second->context->modulus() == modulus) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+            return found->second->context;
+        }
+        evict(shard, found->second);
+    }
+
+    if (context->footprint() > shardBudget) return context;
+
+    shard.lru.push_front(Entry{h, context});
+    shard.index[h] = shard.lru.begin();
+    shard.bytes += context->footprint();
+    while (shard.bytes > shardBudget) evict(shard, std::prev(shard.lru.end()));
+    return context;
+}
+
+void ModulusCache::evict(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= it->context->footprint();
+    shard.index.erase(it->hash);
+    shard.lru.erase(it);
+    ++evictions;
+}
+
+ModulusCacheStats ModulusCache::stats() const {
+    ModulusCacheStats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.evictions = evictions;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        result.entries += shard->lru.size();
+        result.bytes += shard->bytes;
+    }
+    return result;
+}
+
+void ModulusCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->lru.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
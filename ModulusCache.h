@@ -0,0 +1,87 @@
+#ifndef MODULUS_CACHE_H
+#define MODULUS_CACHE_H
+
+#include "BigNumber.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 单个模数的预计算上下文：Barrett 约简参数、位长，以及最近用过的几个公钥指数的二进制形式。
+// 上下文在进程内共享且可能长期驻留，只放公开的模数 n 和公钥指数；私钥的素因子、指数及其导出数据一律不进缓存
+class ModulusContext {
+public:
+    explicit ModulusContext(const BigNumber& modulus);
+
+    const BigNumber& modulus() const { return reducer.modulus; }
+    // 只用于公钥指数 e：结果会缓存在上下文里
+    std::vector<uint32_t> publicExponentWords(const BigNumber& exponent) const;
+    // 不缓存指数，私钥指数走这里
+    BigNumber powmod(const BigNumber& base, const BigNumber& exponent) const;
+    size_t footprint() const { return bytes; }
+
+    static const size_t kMaxExponents = 4;
+
+    BarrettReducer reducer;
+    int bitLength;
+
+private:
+    struct CachedExponent {
+        BigNumber exponent;
+        std::vector<uint32_t> words;
+    };
+
+    mutable std::mutex mutex;
+    mutable std::vector<CachedExponent> exponents; // 最近使用的在最后
+    size_t bytes;
+};
+
+struct ModulusCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// 按模数哈希分片的线程安全 LRU 缓存，总内存按 budgetBytes 平均分到各分片
+class ModulusCache {
+public:
+    explicit ModulusCache(size_t budgetBytes = 64u << 20, size_t shardCount = 16);
+
+    ModulusCache(const ModulusCache&) = delete;
+    ModulusCache& operator=(const ModulusCache&) = delete;
+
+    static ModulusCache& shared();
+
+    // 返回的上下文在被淘汰后仍可安全使用
+    std::shared_ptr<const ModulusContext> get(const BigNumber& modulus);
+    ModulusCacheStats stats() const;
+    void clear();
+
+private:
+    struct Entry {
+        size_t hash;
+        std::shared_ptr<const ModulusContext> context;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru; // 最近使用的在前
+        std::unordered_map<size_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    void evict(Shard& shard, std::list<Entry>::iterator it);
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t shardBudget;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+#endif // MODULUS_CACHE_H
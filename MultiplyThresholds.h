@@ -0,0 +1,8 @@
+// 由 calibrate_mul 生成（make calibrate），阈值单位为十进制位数
+#ifndef MULTIPLY_THRESHOLDS_H
+#define MULTIPLY_THRESHOLDS_H
+
+#define KARATSUBA_THRESHOLD 12
+#define NTT_THRESHOLD 647
+
+#endif // MULTIPLY_THRESHOLDS_H
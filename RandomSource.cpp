@@ -0,0 +1,148 @@
+#include "RandomSource.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <pthread.h>
+#include <sys/random.h>
+#include <unistd.h>
+
+static inline uint32_t rotl(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+// 每个状态字都是 kBlocks 个分组的同一位置，四分之一轮在各分组间逐字并行，便于编译器向量化
+#define QUARTER_ROUND(a, b, c, d)                                             \
+    for (size_t l = 0; l < kLanes; ++l) {                                     \
+        x[a][l] += x[b][l]; x[d][l] = rotl(x[d][l] ^ x[a][l], 16);           \
+        x[c][l] += x[d][l]; x[b][l] = rotl(x[b][l] ^ x[c][l], 12);           \
+        x[a][l] += x[b][l]; x[d][l] = rotl(x[d][l] ^ x[a][l], 8);            \
+        x[c][l] += x[d][l]; x[b][l] = rotl(x[b][l] ^ x[c][l], 7);            \
+    }
+
+template <size_t kLanes>
+static void chacha20Blocks(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3], uint32_t* out) {
+    uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        counter, nonce[0], nonce[1], nonce[2],
+    };
+
+    uint32_t x[16][kLanes];
+    for (int i = 0; i < 16; ++i)
+        for (size_t l = 0; l < kLanes; ++l) x[i][l] = input[i];
+    for (size_t l = 0; l < kLanes; ++l) x[12][l] += static_cast<uint32_t>(l);
+
+    for (int round = 0; round < 10; ++round) {
+        QUARTER_ROUND(0, 4, 8, 12)
+        QUARTER_ROUND(1, 5, 9, 13)
+        QUARTER_ROUND(2, 6, 10, 14)
+        QUARTER_ROUND(3, 7, 11, 15)
+        QUARTER_ROUND(0, 5, 10, 15)
+        QUARTER_ROUND(1, 6, 11, 12)
+        QUARTER_ROUND(2, 7, 8, 13)
+        QUARTER_ROUND(3, 4, 9, 14)
+    }
+
+    for (size_t l = 0; l < kLanes; ++l) {
+        for (int i = 0; i < 16; ++i) {
+            uint32_t in = input[i] + (i == 12 ? static_cast<uint32_t>(l) : 0);
+            out[l * 16 + i] = x[i][l] + in;
+        }
+    }
+}
+
+#undef QUARTER_ROUND
+
+void RandomSource::chacha20Block(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3], uint32_t out[16]) {
+    chacha20Blocks<1>(key, counter, nonce, out);
+}
+
+static void systemEntropy(void* out, size_t size) {
+#if defined(__linux__)
+    char* p = static_cast<char*>(out);
+    while (size > 0) {
+        ssize_t n = getrandom(p, size, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("getrandom failed");
+        }
+        p += n;
+        size -= n;
+    }
+#else
+    if (getentropy(out, size) != 0) throw std::runtime_error("getentropy failed");
+#endif
+}
+
+// fork 之后子进程会复制父进程的状态，子进程里代数加一，各线程下次取数时重新取熵
+static std::atomic<unsigned> forkGeneration(0);
+
+RandomSource& RandomSource::local() {
+    static const int registered = pthread_atfork(nullptr, nullptr, []() { ++forkGeneration; });
+    (void)registered;
+    thread_local RandomSource source;
+    return source;
+}
+
+RandomSource::RandomSource() {
+    reseed();
+}
+
+void RandomSource::reseed() {
+    systemEntropy(key, sizeof(key));
+    counter = 0;
+    generation = forkGeneration.load(std::memory_order_relaxed);
+    refill();
+}
+
+void RandomSource::refill() {
+    chacha20Blocks<kBlocks>(key, counter, nonce, buffer);
+    counter += kBlocks;
+    if (counter == 0) ++nonce[0];
+    std::memcpy(key, buffer, sizeof(key));
+    std::memset(buffer, 0, sizeof(key));
+    position = 8;
+}
+
+void RandomSource::fill(uint32_t* out, size_t count) {
+    if (generation != forkGeneration.load(std::memory_order_relaxed)) reseed();
+    const size_t total = sizeof(buffer) / sizeof(buffer[0]);
+    while (count > 0) {
+        if (position == total) refill();
+        size_t n = std::min(count, total - position);
+        std::memcpy(out, buffer + position, n * sizeof(uint32_t));
+        std::memset(buffer + position, 0, n * sizeof(uint32_t));
+        position += n;
+        out += n;
+        count -= n;
+    }
+}
+
+uint32_t RandomSource::next32() {
+    uint32_t v;
+    fill(&v, 1);
+    return v;
+}
+
+uint64_t RandomSource::next64() {
+    uint32_t v[2];
+    fill(v, 2);
+    return (uint64_t(v[1]) << 32) | v[0];
+}
+
+// Lemire 的乘法取区间法，只在落入偏差区时重抽
+uint32_t RandomSource::uniform(uint32_t bound) {
+    if (bound == 0) throw std::invalid_argument("Bound must be positive");
+    uint64_t m = uint64_t(next32()) * bound;
+    uint32_t low = static_cast<uint32_t>(m);
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = uint64_t(next32()) * bound;
+            low = static_cast<uint32_t>(m);
+        }
+    }
+    return static_cast<uint32_t>(m >> 32);
+}
@@ -0,0 +1,43 @@
+#ifndef RANDOM_SOURCE_H
+#define RANDOM_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 线程私有的 ChaCha20 DRBG：首次使用时从操作系统熵源取 256 位密钥，之后整块批量生成。
+// 每次补充缓冲都先用新生成的 32 字节替换密钥（快速密钥擦除），已输出的随机数无法从当前状态倒推。
+class RandomSource {
+public:
+    static RandomSource& local();
+
+    void fill(uint32_t* out, size_t count);
+    void fill(std::vector<uint32_t>& words) { fill(words.data(), words.size()); }
+    uint32_t next32();
+    uint64_t next64();
+    // [0, bound) 上的均匀整数，bound 必须大于 0
+    uint32_t uniform(uint32_t bound);
+
+    // RFC 8439 的 ChaCha20 分组函数，供测试对照
+    static void chacha20Block(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3], uint32_t out[16]);
+
+    RandomSource(const RandomSource&) = delete;
+    RandomSource& operator=(const RandomSource&) = delete;
+
+private:
+    RandomSource();
+
+    void reseed();
+    void refill();
+
+    static const size_t kBlocks = 16;
+
+    uint32_t key[8];
+    uint32_t nonce[3] = {0, 0, 0};
+    uint32_t counter = 0;
+    uint32_t buffer[16 * kBlocks];
+    size_t position;
+    unsigned generation = 0;
+};
+
+#endif // RANDOM_SOURCE_H
@@ -0,0 +1,190 @@
+#include "RsaAsync.h"
+
+namespace {
+const int kMaxKeyStreak = 8;
+// 共享池的排队上限：突发请求超过时 submit 直接抛出 "RSA job queue full"，由调用方退避重试
+const size_t kSharedMaxQueued = 1024;
+}
+
+RsaWorkerPool::RsaWorkerPool(size_t threadCount, size_t maxQueued) : maxQueued(maxQueued) {
+    if (threadCount == 0) threadCount = 1;
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&RsaWorkerPool::workerLoop, this);
+    }
+}
+
+RsaWorkerPool::~RsaWorkerPool() {
+    std::vector<Task> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto& entry : queues) {
+            for (auto& task : entry.second) pending.push_back(std::move(task));
+        }
+        queues.clear();
+        keyOrder.clear();
+        queued = 0;
+    }
+    available.notify_all();
+    for (auto& t : workers) t.join();
+    for (auto& task : pending) task.abandon();
+}
+
+RsaWorkerPool& RsaWorkerPool::shared() {
+    static RsaWorkerPool pool(std::thread::hardware_concurrency(), kSharedMaxQueued);
+    return pool;
+}
+
+uint64_t RsaWorkerPool::enqueue(const std::string& keyId, std::function<void()> run, std::function<void()> abandon) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) throw std::runtime_error("RSA worker pool is shutting down");
+        if (maxQueued != 0 && queued >= maxQueued) throw std::runtime_error("RSA job queue full");
+
+        id = nextId++;
+        auto& queue = queues[keyId];
+        if (queue.empty()) keyOrder.push_back(keyId);
+        queue.push_back(Task{id, std::move(run), std::move(abandon)});
+        ++queued;
+    }
+    available.notify_one();
+    return id;
+}
+
+bool RsaWorkerPool::cancel(uint64_t jobId) {
+    Task cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool found = false;
+        for (auto it = queues.begin(); it != queues.end() && !found; ++it) {
+            auto& queue = it->second;
+            for (auto task = queue.begin(); task != queue.end(); ++task) {
+                if (task->id != jobId) continue;
+                cancelled = std::move(*task);
+                queue.erase(task);
+                --queued;
+                found = true;
+                break;
+            }
+            if (found && queue.empty()) {
+                std::string keyId = it->first;
+                dropKey(keyId);
+                break;
+            }
+        }
+        if (!found) return false;
+    }
+    cancelled.abandon();
+    return true;
+}
+
+size_t RsaWorkerPool::queueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queued;
+}
+
+size_t RsaWorkerPool::inFlight() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running;
+}
+
+void RsaWorkerPool::dropKey(const std::string& keyId) {
+    queues.erase(keyId);
+    for (auto it = keyOrder.begin(); it != keyOrder.end(); ++it) {
+        if (*it == keyId) {
+            keyOrder.erase(it);
+            break;
+        }
+    }
+}
+
+// 调用时持有 mutex。先尝试上一次处理的密钥，连续处理 kMaxKeyStreak 个后轮转到下一个密钥，避免饿死
+bool RsaWorkerPool::takeTask(std::string& lastKey, int& streak, Task& task) {
+    auto it = queues.end();
+    if (streak < kMaxKeyStreak) it = queues.find(lastKey);
+
+    if (it == queues.end()) {
+        if (keyOrder.empty()) return false;
+        if (keyOrder.front() == lastKey && keyOrder.size() > 1) {
+            keyOrder.push_back(keyOrder.front());
+            keyOrder.pop_front();
+        }
+        lastKey = keyOrder.front();
+        keyOrder.push_back(lastKey);
+        keyOrder.pop_front();
+        streak = 0;
+        it = queues.find(lastKey);
+    }
+
+    task = std::move(it->second.front());
+    it->second.pop_front();
+    if (it->second.empty()) dropKey(lastKey);
+    --queued;
+    ++streak;
+    return true;
+}
+
+void RsaWorkerPool::workerLoop() {
+    std::string lastKey;
+    int streak = 0;
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping) return;
+            if (!takeTask(lastKey, streak, task)) continue;
+            ++running;
+        }
+        task.run();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+        }
+    }
+}
+
+RsaJob<std::vector<BigNumber>> rsaEncryptChunksAsync(const std::string& message, const BigNumber& e, const BigNumber& n, int keyBits) {
+    return RsaWorkerPool::shared().submit(n.toString(), [message, e, n, keyBits]() {
+        return rsaEncryptChunks(message, e, n, keyBits);
+    });
+}
+
+RsaJob<std::string> rsaDecryptChunksAsync(const std::vector<BigNumber>& ciphertexts, const BigNumber& d, const BigNumber& n) {
+    return RsaWorkerPool::shared().submit(n.toString(), [ciphertexts, d, n]() {
+        return rsaDecryptChunks(ciphertexts, d, n);
+    });
+}
+
+RsaJob<std::string> rsaDecryptChunksAsync_crt(const std::vector<BigNumber>& ciphertexts, const RSAPrivateKeyCRT& key) {
+    return RsaWorkerPool::shared().submit(key.n.toString(), [ciphertexts, key]() {
+        return rsaDecryptChunks_crt(ciphertexts, key);
+    });
+}
+
+RsaJob<std::vector<BigNumber>> rsaSignChunksAsync(const std::string& message, const BigNumber& d, const BigNumber& n, int keyBits) {
+    return RsaWorkerPool::shared().submit(n.toString(), [message, d, n, keyBits]() {
+        return rsaSignChunks(message, d, n, keyBits);
+    });
+}
+
+RsaJob<std::vector<BigNumber>> rsaSignChunksAsync_crt(const std::string& message, const RSAPrivateKeyCRT& key, int keyBits) {
+    return RsaWorkerPool::shared().submit(key.n.toString(), [message, key, keyBits]() {
+        return rsaSignChunks_crt(message, key, keyBits);
+    });
+}
+
+RsaJob<bool> rsaVerifyChunksAsync(const std::string& message, const std::vector<BigNumber>& signature, const BigNumber& e, const BigNumber& n) {
+    return RsaWorkerPool::shared().submit(n.toString(), [message, signature, e, n]() {
+        return rsaVerifyChunks(message, signature, e, n);
+    });
+}
+
+RsaJob<RSAPrivateKeyCRT> generateRSAKeyPairAsync(int bits, int primeCount) {
+    return RsaWorkerPool::shared().submit("keygen", [bits, primeCount]() {
+        RSAPrivateKeyCRT key;
+        generateRSAKeyPair_multiPrime(bits, primeCount, key);
+        return key;
+    });
+}
@@ -0,0 +1,95 @@
+#ifndef RSA_ASYNC_H
+#define RSA_ASYNC_H
+
+#include "RsaCrypto.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+template <typename T>
+struct RsaJob {
+    uint64_t id;
+    std::future<T> result;
+};
+
+// 共享的有界工作线程池：同一密钥的任务排在同一队列里，工作线程优先连续处理上一次的密钥，
+// 让该密钥的上下文留在缓存中
+class RsaWorkerPool {
+public:
+    // maxQueued 为排队任务上限，0 表示不限
+    explicit RsaWorkerPool(size_t threadCount, size_t maxQueued = 0);
+    ~RsaWorkerPool();
+
+    RsaWorkerPool(const RsaWorkerPool&) = delete;
+    RsaWorkerPool& operator=(const RsaWorkerPool&) = delete;
+
+    // 进程共享的池，最多排队 1024 个任务，超出时 submit 抛出异常
+    static RsaWorkerPool& shared();
+
+    template <typename F>
+    auto submit(const std::string& keyId, F fn) -> RsaJob<decltype(fn())> {
+        using T = decltype(fn());
+        auto promise = std::make_shared<std::promise<T>>();
+        RsaJob<T> job;
+        job.result = promise->get_future();
+        job.id = enqueue(keyId,
+            [promise, fn]() mutable {
+                try {
+                    promise->set_value(fn());
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+            },
+            [promise]() {
+                promise->set_exception(std::make_exception_ptr(std::runtime_error("RSA job cancelled")));
+            });
+        return job;
+    }
+
+    // 只能取消尚未开始的任务，被取消任务的 future 会抛出异常
+    bool cancel(uint64_t jobId);
+    size_t queueDepth() const;
+    size_t inFlight() const;
+
+private:
+    struct Task {
+        uint64_t id;
+        std::function<void()> run;
+        std::function<void()> abandon;
+    };
+
+    uint64_t enqueue(const std::string& keyId, std::function<void()> run, std::function<void()> abandon);
+    void workerLoop();
+    bool takeTask(std::string& lastKey, int& streak, Task& task);
+    void dropKey(const std::string& keyId);
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::unordered_map<std::string, std::deque<Task>> queues; // 只保存非空队列
+    std::deque<std::string> keyOrder;
+    std::vector<std::thread> workers;
+    size_t maxQueued;
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t nextId = 1;
+    bool stopping = false;
+};
+
+RsaJob<std::vector<BigNumber>> rsaEncryptChunksAsync(const std::string& message, const BigNumber& e, const BigNumber& n, int keyBits);
+RsaJob<std::string> rsaDecryptChunksAsync(const std::vector<BigNumber>& ciphertexts, const BigNumber& d, const BigNumber& n);
+RsaJob<std::string> rsaDecryptChunksAsync_crt(const std::vector<BigNumber>& ciphertexts, const RSAPrivateKeyCRT& key);
+RsaJob<std::vector<BigNumber>> rsaSignChunksAsync(const std::string& message, const BigNumber& d, const BigNumber& n, int keyBits);
+RsaJob<std::vector<BigNumber>> rsaSignChunksAsync_crt(const std::string& message, const RSAPrivateKeyCRT& key, int keyBits);
+RsaJob<bool> rsaVerifyChunksAsync(const std::string& message, const std::vector<BigNumber>& signature, const BigNumber& e, const BigNumber& n);
+RsaJob<RSAPrivateKeyCRT> generateRSAKeyPairAsync(int bits, int primeCount = 2);
+
+#endif // RSA_ASYNC_H
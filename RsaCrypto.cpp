@@ -1,6 +1,9 @@
 #include "RsaCrypto.h"
+#include "ModulusCache.h"
+#include "TaskPool.h"
 #include <algorithm>
 #include <stdexcept>
+#include <atomic>
 
 BigNumber bytesToBigNumber(const std::vector<uint8_t>& bytes) {
     BigNumber result("0");
@@ -27,11 +30,11 @@ std::vector<uint8_t> bigNumberToBytes(BigNumber number) {
     return bytes;
 }
 
-std::vector<BigNumber> rsaEncryptChunks(const std::string& message, const BigNumber& e, const BigNumber& n, int keyBits) {
+static std::vector<BigNumber> packBlocks(const std::string& message, const BigNumber& n, int keyBits) {
     int k = keyBits / 8;
     if (k < 2) throw std::invalid_argument("Key size too small for padding");
 
-    std::vector<BigNumber> ciphertexts;
+    std::vector<BigNumber> blocks;
     size_t fullBlocks = message.size() / (k - 1);
     size_t lastBlockLen = message.size() % (k - 1);
 
@@ -42,7 +45,7 @@ std::vector<BigNumber> rsaEncryptChunks(const std::string& message, const BigNum
 
         BigNumber m = bytesToBigNumber(chunk);
         if (m >= n) throw std::runtime_error("Block too large");
-        ciphertexts.push_back(m.powmod(e, n));
+        blocks.push_back(m);
     }
 
     if (lastBlockLen > 0) {
@@ -53,18 +56,65 @@ std::vector<BigNumber> rsaEncryptChunks(const std::string& message, const BigNum
 
         BigNumber m = bytesToBigNumber(lastChunk);
         if (m >= n) throw std::runtime_error("Last block too large after padding");
-        ciphertexts.push_back(m.powmod(e, n));
+        blocks.push_back(m);
+    }
+
+    return blocks;
+}
+
+static void unpackBlock(const BigNumber& m, int& k, std::string& result) {
+    std::vector<uint8_t> bytes = bigNumberToBytes(m);
+
+    if (k == 0) k = bytes.size();
+    if (bytes.empty()) return;
+
+    uint8_t plainLen = bytes[0];
+    if (plainLen > k - 1) {
+        throw std::runtime_error("Invalid padding length");
     }
 
+    for (size_t i = 1; i <= plainLen; ++i) {
+        result.push_back(static_cast<char>(bytes[i]));
+    }
+}
+
+std::vector<BigNumber> rsaEncryptChunks(const std::string& message, const BigNumber& e, const BigNumber& n, int keyBits) {
+    auto context = ModulusCache::shared().get(n);
+    std::vector<uint32_t> exponent = context->publicExponentWords(e);
+    std::vector<BigNumber> ciphertexts;
+    for (const auto& m : packBlocks(message, n, keyBits)) {
+        ciphertexts.push_back(m.powmodWords(exponent, context->reducer));
+    }
     return ciphertexts;
 }
 
 std::string rsaDecryptChunks(const std::vector<BigNumber>& ciphertexts, const BigNumber& d, const BigNumber& n) {
+    auto context = ModulusCache::shared().get(n);
+    std::vector<uint32_t> exponent = d.toBinaryWords();
     std::string result;
     int k = 0;
     for (const auto& c : ciphertexts) {
-        BigNumber m = c.powmod(d, n);
-        std::vector<uint8_t> bytes = bigNumberToBytes(m);
+        unpackBlock(c.powmodWords(exponent, context->reducer), k, result);
+    }
+    return result;
+}
+
+std::vector<BigNumber> rsaSignChunks(const std::string& message, const BigNumber& d, const BigNumber& n, int keyBits) {
+    auto context = ModulusCache::shared().get(n);
+    std::vector<uint32_t> exponent = d.toBinaryWords();
+    std::vector<BigNumber> signatures;
+    for (const auto& m : packBlocks(message, n, keyBits)) {
+        signatures.push_back(m.powmodWords(exponent, context->reducer));
+    }
+    return signatures;
+}
+
+// 逐块与消息对应片段比较，一旦不匹配立即返回，不拼接完整的恢复消息
+static bool verifyBlocks(const std::string& message, const std::vector<BigNumber>& signature, const std::vector<uint32_t>& exponent, const BarrettReducer& reducer) {
+    size_t offset = 0;
+    int k = 0;
+    for (const auto& c : signature) {
+        std::vector<uint8_t> bytes = bigNumberToBytes(c.powmodWords(exponent, reducer));
 
         if (k == 0) k = bytes.size();
         if (bytes.empty()) continue;
@@ -73,62 +123,304 @@ std::string rsaDecryptChunks(const std::vector<BigNumber>& ciphertexts, const Bi
         if (plainLen > k - 1) {
             throw std::runtime_error("Invalid padding length");
         }
+        if (plainLen > message.size() - offset) return false;
 
         for (size_t i = 1; i <= plainLen; ++i) {
-            result.push_back(static_cast<char>(bytes[i]));
+            if (static_cast<char>(bytes[i]) != message[offset++]) return false;
         }
     }
-    return result;
+    return offset == message.size();
 }
 
-std::vector<BigNumber> rsaSignChunks(const std::string& message, const BigNumber& d, const BigNumber& n, int keyBits) {
-    int k = keyBits / 8;
-    if (k < 2) throw std::invalid_argument("Key size too small for padding");
+bool rsaVerifyChunks(const std::string& message, const std::vector<BigNumber>& signature, const BigNumber& e, const BigNumber& n) {
+    auto context = ModulusCache::shared().get(n);
+    return verifyBlocks(message, signature, context->publicExponentWords(e), context->reducer);
+}
 
-    std::vector<BigNumber> signatures;
-    size_t fullBlocks = message.size() / (k - 1);
-    size_t lastBlockLen = message.size() % (k - 1);
+// 大端字节串与 BigNumber 互转，经由 32 位二进制字
+static BigNumber fromBigEndian(const uint8_t* bytes, size_t length) {
+    std::vector<uint32_t> words((length + 3) / 4, 0);
+    for (size_t i = 0; i < length; ++i) {
+        size_t shift = length - 1 - i;
+        words[shift / 4] |= uint32_t(bytes[i]) << (8 * (shift % 4));
+    }
+    return BigNumber::fromBinaryWords(words);
+}
 
-    for (size_t i = 0; i < fullBlocks; ++i) {
-        std::vector<uint8_t> chunk;
-        chunk.push_back(k - 1);
-        chunk.insert(chunk.end(), message.begin() + i * (k - 1), message.begin() + (i + 1) * (k - 1));
-        BigNumber m = bytesToBigNumber(chunk);
-        if (m >= n) throw std::runtime_error("Block too large");
-        signatures.push_back(m.powmod(d, n));
+static void appendBigEndian(const BigNumber& number, size_t width, std::vector<uint8_t>& out) {
+    std::vector<uint32_t> words = number.toBinaryWords();
+    for (size_t i = width / 4; i < words.size(); ++i) {
+        uint32_t excess = (i == width / 4 && width % 4) ? words[i] >> (8 * (width % 4)) : words[i];
+        if (excess) throw std::runtime_error("Block too large");
+    }
+    for (size_t shift = width; shift-- > 0;) {
+        size_t w = shift / 4;
+        out.push_back(w < words.size() ? static_cast<uint8_t>(words[w] >> (8 * (shift % 4))) : 0);
     }
+}
 
-    if (lastBlockLen > 0) {
-        std::vector<uint8_t> lastChunk;
-        lastChunk.push_back(static_cast<uint8_t>(lastBlockLen));
-        lastChunk.insert(lastChunk.end(), message.end() - lastBlockLen, message.end());
-        lastChunk.resize(k, 0);
-        BigNumber m = bytesToBigNumber(lastChunk);
-        if (m >= n) throw std::runtime_error("Last block too large after padding");
-        signatures.push_back(m.powmod(d, n));
+std::vector<uint8_t> rsaEncryptPacked(const std::string& message, const BigNumber& e, const BigNumber& n) {
+    auto context = ModulusCache::shared().get(n);
+    int bits = context->bitLength;
+    size_t payload = (bits - 1) / 8;
+    size_t width = (bits + 7) / 8;
+    if (payload < 1) throw std::invalid_argument("Modulus too small for packing");
+    if (message.size() > UINT32_MAX) throw std::invalid_argument("Message too long");
+
+    std::vector<uint8_t> plain;
+    plain.reserve(4 + message.size() + payload);
+    for (int shift = 24; shift >= 0; shift -= 8) plain.push_back(static_cast<uint8_t>(message.size() >> shift));
+    plain.insert(plain.end(), message.begin(), message.end());
+    plain.resize((plain.size() + payload - 1) / payload * payload, 0);
+
+    std::vector<uint32_t> exponent = context->publicExponentWords(e);
+    std::vector<uint8_t> ciphertext;
+    ciphertext.reserve(plain.size() / payload * width);
+    for (size_t offset = 0; offset < plain.size(); offset += payload) {
+        BigNumber m = fromBigEndian(plain.data() + offset, payload);
+        appendBigEndian(m.powmodWords(exponent, context->reducer), width, ciphertext);
     }
+    return ciphertext;
+}
 
-    return signatures;
+std::string rsaDecryptPacked(const std::vector<uint8_t>& ciphertext, const BigNumber& d, const BigNumber& n) {
+    auto context = ModulusCache::shared().get(n);
+    int bits = context->bitLength;
+    size_t payload = (bits - 1) / 8;
+    size_t width = (bits + 7) / 8;
+    if (payload < 1) throw std::invalid_argument("Modulus too small for packing");
+    if (ciphertext.size() % width) throw std::runtime_error("Ciphertext is not a whole number of blocks");
+
+    std::vector<uint32_t> exponent = d.toBinaryWords();
+    std::vector<uint8_t> plain;
+    plain.reserve(ciphertext.size() / width * payload);
+    for (size_t offset = 0; offset < ciphertext.size(); offset += width) {
+        BigNumber c = fromBigEndian(ciphertext.data() + offset, width);
+        if (c >= n) throw std::runtime_error("Ciphertext block out of range");
+        appendBigEndian(c.powmodWords(exponent, context->reducer), payload, plain);
+    }
+
+    if (plain.size() < 4) throw std::runtime_error("Missing length header");
+    size_t length = 0;
+    for (int i = 0; i < 4; ++i) length = (length << 8) | plain[i];
+    if (length > plain.size() - 4) throw std::runtime_error("Invalid length header");
+    return std::string(plain.begin() + 4, plain.begin() + 4 + length);
 }
 
-bool rsaVerifyChunks(const std::string& message, const std::vector<BigNumber>& signature, const BigNumber& e, const BigNumber& n) {
-    std::string recovered;
+std::vector<bool> rsaVerifyBatch(const std::vector<std::pair<std::string, std::vector<BigNumber>>>& items, const BigNumber& e, const BigNumber& n) {
+    auto context = ModulusCache::shared().get(n);
+    std::vector<uint32_t> exponent = context->publicExponentWords(e);
+    std::vector<char> passed(items.size(), 0);
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < items.size(); i = next++) {
+            try {
+                passed[i] = verifyBlocks(items[i].first, items[i].second, exponent, context->reducer);
+            } catch (const std::exception&) {
+                passed[i] = false;
+            }
+        }
+    };
+
+    // 在共享任务池上执行，不另开线程；每个任务从同一个计数器领取条目
+    TaskPool& pool = TaskPool::shared();
+    std::vector<std::function<void()>> tasks(std::min(pool.workerCount() + 1, items.size()), worker);
+    pool.run(tasks);
+
+    return std::vector<bool>(passed.begin(), passed.end());
+}
+
+BigNumber rsaPrivateCRT(const BigNumber& c, const RSAPrivateKeyCRT& key) {
+    size_t u = key.primes.size();
+    std::vector<BigNumber> residues(u);
+
+    // 素因子是秘密，约简参数只从私钥里取或现场构造，不经过共享的 ModulusCache
+    std::vector<BarrettReducer> local;
+    const std::vector<BarrettReducer>* reducers = &key.reducers;
+    if (key.reducers.size() != u) {
+        for (const auto& r : key.primes) local.emplace_back(r);
+        reducers = &local;
+    }
+
+    // 各素数上的模幂互不依赖，作为共享任务池的任务执行；结果可能在别的线程算出，关闭 arena
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < u; ++i) {
+        tasks.push_back([&, i]() {
+            ArenaSuspend suspend;
+            residues[i] = (c % key.primes[i]).powmod(key.exponents[i], (*reducers)[i]);
+        });
+    }
+    TaskPool::shared().run(tasks);
+
+    // Garner 重组：m = m + R * ((m_i - m) * t_i mod r_i)，R = r_1 * ... * r_{i-1}
+    BigNumber m = residues[0];
+    BigNumber R = key.primes[0];
+    for (size_t i = 1; i < u; ++i) {
+        const BigNumber& r = key.primes[i];
+        BigNumber diff = residues[i] - m % r;
+        if (diff < BigNumber(0)) diff = diff + r;
+        BigNumber h = (diff * key.coefficients[i]) % r;
+        m = m + R * h;
+        R = R * r;
+    }
+    return m;
+}
+
+std::string rsaDecryptChunks_crt(const std::vector<BigNumber>& ciphertexts, const RSAPrivateKeyCRT& key) {
+    std::string result;
     int k = 0;
-    for (const auto& c : signature) {
-        BigNumber m = c.powmod(e, n);
-        std::vector<uint8_t> bytes = bigNumberToBytes(m);
+    for (const auto& c : ciphertexts) {
+        unpackBlock(rsaPrivateCRT(c, key), k, result);
+    }
+    return result;
+}
 
-        if (k == 0) k = bytes.size();
-        if (bytes.empty()) continue;
+std::vector<BigNumber> rsaSignChunks_crt(const std::string& message, const RSAPrivateKeyCRT& key, int keyBits) {
+    std::vector<BigNumber> signatures;
+    for (const auto& m : packBlocks(message, key.n, keyBits)) {
+        signatures.push_back(rsaPrivateCRT(m, key));
+    }
+    return signatures;
+}
 
-        uint8_t plainLen = bytes[0];
-        if (plainLen > k - 1) {
-            throw std::runtime_error("Invalid padding length");
-        }
+struct BatchNode {
+    BigNumber E;    // 子树内各 e_i 之积
+    BigNumber A;    // 子树内 c_i^{E / e_i} 之积 mod n
+    BigNumber invA; // A^-1 mod n
+    int left = -1, right = -1;
+    size_t leaf = 0;
+};
 
-        for (size_t i = 1; i <= plainLen; ++i) {
-            recovered.push_back(static_cast<char>(bytes[i]));
+static BigNumber gcd(BigNumber a, BigNumber b) {
+    while (b != BigNumber(0)) {
+        BigNumber r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// Montgomery 技巧：整批只做一次模逆，其余用前缀积回推。
+// 只要有一个值与 n 不互素，整批之积就没有逆元，此时返回 false
+static bool batchInverse(const std::vector<BigNumber>& values, const BigNumber& n, const BarrettReducer& reducer,
+                         std::vector<BigNumber>& inverses) {
+    std::vector<BigNumber> prefix(values.size());
+    prefix[0] = values[0];
+    for (size_t i = 1; i < values.size(); ++i) prefix[i] = reducer.reduce(prefix[i - 1] * values[i]);
+
+    if (gcd(prefix.back(), n) != BigNumber(1)) return false;
+    BigNumber inv = prefix.back().modinv(n);
+    inverses.assign(values.size(), BigNumber());
+    for (size_t i = values.size() - 1; i > 0; --i) {
+        inverses[i] = reducer.reduce(inv * prefix[i - 1]);
+        inv = reducer.reduce(inv * values[i]);
+    }
+    inverses[0] = inv;
+    return true;
+}
+
+// 自底向上建积树：A = A_L^{E_R} * A_R^{E_L}，根处 A^{1/E} 即各明文之积
+static int buildBatchTree(std::vector<BatchNode>& nodes, const std::vector<std::pair<size_t, BigNumber>>& items,
+                          const std::vector<BigNumber>& inverses, const RSABatchKeySet& keys,
+                          const BarrettReducer& reducer, size_t lo, size_t hi) {
+    BatchNode node;
+    if (hi - lo == 1) {
+        node.E = keys.exponents[items[lo].first];
+        node.A = items[lo].second;
+        node.invA = inverses[lo];
+        node.leaf = lo;
+    } else {
+        size_t mid = (lo + hi) / 2;
+        node.left = buildBatchTree(nodes, items, inverses, keys, reducer, lo, mid);
+        node.right = buildBatchTree(nodes, items, inverses, keys, reducer, mid, hi);
+        const BatchNode& L = nodes[node.left];
+        const BatchNode& R = nodes[node.right];
+        node.E = L.E * R.E;
+        node.A = BigNumber::multiPowmod({{L.A, R.E}, {R.A, L.E}}, reducer);
+        node.invA = BigNumber::multiPowmod({{L.invA, R.E}, {R.invA, L.E}}, reducer);
+    }
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+// 自顶向下拆分 M = M_L * M_R：取 X ≡ 0 (mod E_L)、X ≡ 1 (mod E_R)，
+// 则 M_R = M^X / (A_L^{X/E_L} * A_R^{(X-1)/E_R})；M_L 取对称的 Y = E_L * E_R + 1 - X，
+// 除法都换成乘以预先求好的 A^-1，不再逐节点求模逆
+static void percolateBatch(const std::vector<BatchNode>& nodes, int index, const BigNumber& M,
+                           const BarrettReducer& reducer, std::vector<BigNumber>& out) {
+    const BatchNode& node = nodes[index];
+    if (node.left < 0) {
+        out[node.leaf] = M;
+        return;
+    }
+
+    const BatchNode& L = nodes[node.left];
+    const BatchNode& R = nodes[node.right];
+    BigNumber one(1);
+    BigNumber X = L.E * L.E.modinv(R.E);
+    BigNumber Y = node.E + one - X;
+
+    BigNumber MR = BigNumber::multiPowmod({{M, X}, {L.invA, X / L.E}, {R.invA, (X - one) / R.E}}, reducer);
+    BigNumber ML = BigNumber::multiPowmod({{M, Y}, {L.invA, (Y - one) / L.E}, {R.invA, Y / R.E}}, reducer);
+
+    percolateBatch(nodes, node.left, ML, reducer, out);
+    percolateBatch(nodes, node.right, MR, reducer, out);
+}
+
+std::vector<BigNumber> rsaBatchDecrypt(const std::vector<std::pair<size_t, BigNumber>>& items, const RSABatchKeySet& keys) {
+    std::vector<char> used(keys.exponents.size(), 0);
+    for (const auto& item : items) {
+        if (item.first >= keys.exponents.size()) throw std::out_of_range("Exponent index out of range");
+        if (used[item.first]++) throw std::invalid_argument("Exponents in a batch must be distinct");
+        if (item.second >= keys.n) throw std::invalid_argument("Ciphertext block out of range");
+    }
+
+    if (items.empty()) return {};
+    auto context = ModulusCache::shared().get(keys.n);
+    const BarrettReducer& reducer = context->reducer;
+    if (items.size() == 1) {
+        return {context->powmod(items[0].second, keys.privateExponents[items[0].first])};
+    }
+
+    std::vector<BigNumber> ciphertexts;
+    for (const auto& item : items) ciphertexts.push_back(item.second);
+    std::vector<BigNumber> inverses;
+    if (!batchInverse(ciphertexts, keys.n, reducer, inverses)) {
+        // 有密文与 n 不互素（如 c = 0）：这些单独解密，其余的照常批量解密
+        std::vector<BigNumber> plaintexts(items.size());
+        std::vector<std::pair<size_t, BigNumber>> units;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < items.size(); ++i) {
+            const BigNumber& c = items[i].second;
+            if (gcd(c, keys.n) == BigNumber(1)) {
+                units.push_back(items[i]);
+                positions.push_back(i);
+            } else {
+                plaintexts[i] = context->powmod(c, keys.privateExponents[items[i].first]);
+            }
         }
+        std::vector<BigNumber> batch = rsaBatchDecrypt(units, keys);
+        for (size_t i = 0; i < positions.size(); ++i) plaintexts[positions[i]] = batch[i];
+        return plaintexts;
     }
-    return recovered == message;
-}
\ No newline at end of file
+
+    std::vector<BatchNode> nodes;
+    nodes.reserve(2 * items.size());
+    int root = buildBatchTree(nodes, items, inverses, keys, reducer, 0, items.size());
+
+    // 根处唯一一次全长模幂：A^{E^-1 mod phi}，借用 CRT 私钥运算
+    RSAPrivateKeyCRT rootKey;
+    rootKey.n = keys.n;
+    rootKey.e = nodes[root].E;
+    rootKey.d = rootKey.e.modinv(keys.phi);
+    rootKey.primes = keys.primes;
+    rootKey.coefficients = keys.coefficients;
+    rootKey.reducers = keys.reducers;
+    for (const auto& r : keys.primes) rootKey.exponents.push_back(rootKey.d % (r - BigNumber(1)));
+    BigNumber M = rsaPrivateCRT(nodes[root].A, rootKey);
+
+    std::vector<BigNumber> plaintexts(items.size());
+    percolateBatch(nodes, root, M, reducer, plaintexts);
+    return plaintexts;
+}
@@ -2,9 +2,11 @@
 #define RSA_CRYPTO_H
 
 #include "BigNumber.h"
+#include "GenerateKey.h"
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <utility>
 
 BigNumber bytesToBigNumber(const std::vector<uint8_t>& bytes);
 std::vector<uint8_t> bigNumberToBytes(BigNumber number);
@@ -14,5 +16,21 @@ std::string rsaDecryptChunks(const std::vector<BigNumber>& ciphertexts, const Bi
 
 std::vector<BigNumber> rsaSignChunks(const std::string& message, const BigNumber& d, const BigNumber& n, int keyBits);
 bool rsaVerifyChunks(const std::string& message, const std::vector<BigNumber>& signature, const BigNumber& e, const BigNumber& n);
+// 批量验签：同一公钥 (e, n) 下的多组 (消息, 签名)，返回逐项结果
+std::vector<bool> rsaVerifyBatch(const std::vector<std::pair<std::string, std::vector<BigNumber>>>& items, const BigNumber& e, const BigNumber& n);
+
+// 满宽度打包：明文前加 4 字节长度头后按 (L-1)/8 字节分块（L 为 n 的位数），
+// 密文为定长 ceil(L/8) 字节的大端块依次拼接
+std::vector<uint8_t> rsaEncryptPacked(const std::string& message, const BigNumber& e, const BigNumber& n);
+std::string rsaDecryptPacked(const std::vector<uint8_t>& ciphertext, const BigNumber& d, const BigNumber& n);
+
+// 多素数 CRT 私钥运算：各素数上的模幂并行执行，再用 Garner 算法重组
+BigNumber rsaPrivateCRT(const BigNumber& c, const RSAPrivateKeyCRT& key);
+std::string rsaDecryptChunks_crt(const std::vector<BigNumber>& ciphertexts, const RSAPrivateKeyCRT& key);
+std::vector<BigNumber> rsaSignChunks_crt(const std::string& message, const RSAPrivateKeyCRT& key, int keyBits);
+
+// Fiat 批量解密：items 为 (指数下标 i, 密文块 c)，同一批内下标互不相同；
+// 返回 c^{d_i} mod n，整批只做一次全长模幂，其余为小指数运算；与 n 不互素的密文（如 0）单独解密
+std::vector<BigNumber> rsaBatchDecrypt(const std::vector<std::pair<size_t, BigNumber>>& items, const RSABatchKeySet& keys);
 
 #endif // RSA_CRYPTO_H
@@ -0,0 +1,125 @@
+#include "TaskPool.h"
+
+namespace {
+thread_local const TaskPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+TaskPool::TaskPool(size_t workerCount) {
+    for (size_t i = 0; i <= workerCount; ++i) {
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+    for (size_t i = 1; i <= workerCount; ++i) {
+        workers.emplace_back(&TaskPool::workerLoop, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+TaskPool& TaskPool::shared() {
+    static TaskPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+    return pool;
+}
+
+size_t TaskPool::currentIndex() const {
+    return currentPool == this ? currentWorker : 0;
+}
+
+TaskPool::TaskHandle TaskPool::spawn(std::function<void()> fn) {
+    TaskHandle task = std::make_shared<Task>();
+    task->fn = std::move(fn);
+
+    Queue& queue = *queues[currentIndex()];
+    ++pending;
+    spawned.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+    return task;
+}
+
+bool TaskPool::runOne(size_t self) {
+    TaskHandle task;
+
+    if (self != 0) {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    for (size_t i = 0; !task && i < queues.size(); ++i) {
+        size_t victim = (self + i) % queues.size();
+        if (victim == self && self != 0) continue;
+        Queue& queue = *queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+
+    if (!task) return false;
+    --pending;
+    try {
+        task->fn();
+    } catch (...) {
+        task->error = std::current_exception();
+    }
+    task->done.store(true, std::memory_order_release);
+    return true;
+}
+
+void TaskPool::join(const TaskHandle& task) {
+    size_t self = currentIndex();
+    while (!task->done.load(std::memory_order_acquire)) {
+        if (!runOne(self)) std::this_thread::yield();
+    }
+    if (task->error) std::rethrow_exception(task->error);
+}
+
+void TaskPool::run(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) return;
+
+    std::vector<TaskHandle> handles;
+    for (size_t i = 0; i + 1 < tasks.size(); ++i) handles.push_back(spawn(tasks[i]));
+
+    std::exception_ptr error;
+    try {
+        tasks.back()();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    for (auto& handle : handles) {
+        try {
+            join(handle);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+void TaskPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    while (!stopping) {
+        if (runOne(index)) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || pending > 0; });
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取式 fork-join 线程池：工作线程各有一个双端队列，自己从尾部取，空闲时从别人头部窃取；
+// join 等待期间调用线程也会执行队列里的任务，所以嵌套 fork 不会死锁
+class TaskPool {
+public:
+    struct Task {
+        std::function<void()> fn;
+        std::atomic<bool> done{false};
+        std::exception_ptr error;
+    };
+    using TaskHandle = std::shared_ptr<Task>;
+
+    explicit TaskPool(size_t workerCount);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    static TaskPool& shared();
+
+    size_t workerCount() const { return workers.size(); }
+    // 累计 spawn 过的任务数
+    size_t spawnedTasks() const { return spawned.load(std::memory_order_relaxed); }
+    TaskHandle spawn(std::function<void()> fn);
+    void join(const TaskHandle& task);
+    // 最后一个任务在当前线程执行，其余交给任务池；全部完成后重抛第一个异常
+    void run(std::vector<std::function<void()>>& tasks);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<TaskHandle> tasks;
+    };
+
+    // queues[0] 是外部线程共用的注入队列，queues[i] 属于第 i 个工作线程
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> spawned{0};
+    std::atomic<bool> stopping{false};
+
+    size_t currentIndex() const;
+    bool runOne(size_t self);
+    void workerLoop(size_t index);
+};
+
+#endif // TASK_POOL_H
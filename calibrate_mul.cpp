@@ -0,0 +1,90 @@
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "BigNumber.h"
+
+// 用法：./calibrate_mul > MultiplyThresholds.h
+// 对每个候选长度比较"顶层用新算法、子问题用旧算法"与"全部用旧算法"的耗时，取新算法开始稳定胜出的长度
+
+const size_t kNever = static_cast<size_t>(-1);
+
+std::string randomDigits(size_t n, std::mt19937& gen) {
+    std::uniform_int_distribution<int> dist(0, 9);
+    std::string s(1, '1' + dist(gen) % 9);
+    while (s.size() < n) s += '0' + dist(gen);
+    return s;
+}
+
+// Toom-3 不参与阈值分派（见 BigNumber::MultiplyThresholds），这里只标定 Karatsuba 和 NTT
+void setThresholds(size_t karatsuba, size_t ntt) {
+    BigNumber::multiplyThresholds.karatsuba = karatsuba;
+    BigNumber::multiplyThresholds.toom3 = kNever;
+    BigNumber::multiplyThresholds.ntt = ntt;
+}
+
+double timeMultiply(const BigNumber& a, const BigNumber& b) {
+    int reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    do {
+        BigNumber c = a * b;
+        ++reps;
+        elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < 0.05);
+    return elapsed.count() / reps;
+}
+
+size_t findThreshold(const std::vector<size_t>& sizes, size_t fallback, std::mt19937& gen,
+                     const std::function<void(size_t)>& useOld, const std::function<void(size_t)>& useNew) {
+    size_t threshold = fallback;
+    int wins = 0;
+    for (size_t n : sizes) {
+        BigNumber a(randomDigits(n, gen)), b(randomDigits(n, gen));
+        useOld(n);
+        double oldTime = timeMultiply(a, b);
+        useNew(n);
+        double newTime = timeMultiply(a, b);
+        std::cerr << "  n=" << n << " old=" << oldTime * 1e6 << "us new=" << newTime * 1e6 << "us\n";
+        if (newTime < oldTime) {
+            if (wins++ == 0) threshold = n;
+            if (wins == 2) return threshold;
+        } else {
+            wins = 0;
+            threshold = fallback;
+        }
+    }
+    return threshold;
+}
+
+std::vector<size_t> geometricSizes(size_t from, size_t to) {
+    std::vector<size_t> sizes;
+    for (size_t n = from; n <= to; n = n * 5 / 4) sizes.push_back(n);
+    return sizes;
+}
+
+int main() {
+    std::mt19937 gen(12345);
+
+    std::cerr << "Calibrating schoolbook -> Karatsuba\n";
+    size_t karatsuba = findThreshold(
+        {8, 12, 16, 24, 32, 40, 48, 64, 80, 96, 128}, 32, gen,
+        [](size_t n) { setThresholds(n + 1, kNever); },
+        [](size_t n) { setThresholds(n, kNever); });
+
+    std::cerr << "Calibrating Karatsuba -> NTT\n";
+    size_t ntt = findThreshold(
+        geometricSizes(karatsuba * 2, 100000), 100000, gen,
+        [karatsuba](size_t) { setThresholds(karatsuba, kNever); },
+        [karatsuba](size_t n) { setThresholds(karatsuba, n); });
+
+    std::cout << "// 由 calibrate_mul 生成（make calibrate），阈值单位为十进制位数\n"
+              << "#ifndef MULTIPLY_THRESHOLDS_H\n"
+              << "#define MULTIPLY_THRESHOLDS_H\n\n"
+              << "#define KARATSUBA_THRESHOLD " << karatsuba << "\n"
+              << "#define NTT_THRESHOLD " << ntt << "\n\n"
+              << "#endif // MULTIPLY_THRESHOLDS_H\n";
+    return 0;
+}
@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GenerateKey.h"
+#include "RsaCrypto.h"
+
+// 持续压测工具：按给定比例混合 sign/verify/encrypt/decrypt/keygen，
+// 用多个线程跑满指定时长或次数，输出吞吐量和延迟分位数（文本或 JSON）
+//
+// 用法示例：
+//   ./rsa_loadgen --mix sign=4,verify=4,encrypt=1,decrypt=1 --sizes 32:1,256:1
+//                 --key-bits 512 --threads 4 --duration 30 --json
+
+enum Op { SIGN, VERIFY, ENCRYPT, DECRYPT, KEYGEN, OP_COUNT };
+const char* const kOpNames[OP_COUNT] = {"sign", "verify", "encrypt", "decrypt", "keygen"};
+
+// HDR 风格的对数-线性直方图：每个 2 的幂区间再均分为 32 格，相对误差约 3%
+class LatencyHistogram {
+public:
+    LatencyHistogram() : buckets(kBucketCount, 0) {}
+
+    void record(uint64_t ns) {
+        ++buckets[indexOf(ns)];
+        ++count;
+        sum += ns;
+        minValue = std::min(minValue, ns);
+        maxValue = std::max(maxValue, ns);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBucketCount; ++i) buckets[i] += other.buckets[i];
+        count += other.count;
+        sum += other.sum;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    uint64_t percentile(double p) const {
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * count));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) return std::min(upperBound(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    uint64_t total() const { return count; }
+    uint64_t min() const { return count ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return count ? static_cast<double>(sum) / count : 0; }
+
+private:
+    static const int kSubBits = 5;
+    static const uint64_t kLinear = uint64_t(1) << (kSubBits + 1);
+    static const size_t kBucketCount = kLinear + (64 - kSubBits) * (size_t(1) << kSubBits);
+
+    static size_t indexOf(uint64_t v) {
+        if (v < kLinear) return v;
+        int magnitude = 63 - __builtin_clzll(v);
+        int shift = magnitude - kSubBits;
+        return kLinear + (shift - 1) * (size_t(1) << kSubBits) + ((v >> shift) - (uint64_t(1) << kSubBits));
+    }
+
+    static uint64_t upperBound(size_t index) {
+        if (index < kLinear) return index;
+        size_t offset = index - kLinear;
+        int shift = offset / (size_t(1) << kSubBits) + 1;
+        uint64_t sub = offset % (size_t(1) << kSubBits) + (uint64_t(1) << kSubBits);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t minValue = UINT64_MAX;
+    uint64_t maxValue = 0;
+};
+
+struct Options {
+    double weights[OP_COUNT] = {1, 1, 1, 1, 0};
+    std::vector<std::pair<size_t, double>> sizes = {{64, 1}};
+    int keyBits = 512;
+    int threads = 1;
+    double duration = 10;
+    uint64_t count = 0;
+    bool json = false;
+};
+
+struct Sample {
+    std::string message;
+    std::vector<BigNumber> signature;
+    std::vector<BigNumber> ciphertext;
+};
+
+struct WorkerStats {
+    LatencyHistogram latency[OP_COUNT];
+    uint64_t errors[OP_COUNT] = {};
+};
+
+void usage() {
+    std::cerr << "Usage: rsa_loadgen [--mix op=w,...] [--sizes bytes:w,...] [--key-bits N]\n"
+              << "                   [--threads N] [--duration SECONDS | --count OPS] [--json]\n"
+              << "  ops: sign verify encrypt decrypt keygen\n";
+}
+
+std::vector<std::pair<std::string, std::string>> splitPairs(const std::string& text, char sep) {
+    std::vector<std::pair<std::string, std::string>> pairs;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t pos = item.find(sep);
+        if (pos == std::string::npos) throw std::invalid_argument("Malformed list item: " + item);
+        pairs.emplace_back(item.substr(0, pos), item.substr(pos + 1));
+    }
+    return pairs;
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--mix") {
+            std::fill(options.weights, options.weights + OP_COUNT, 0);
+            for (const auto& kv : splitPairs(value(), '=')) {
+                auto name = std::find(kOpNames, kOpNames + OP_COUNT, kv.first);
+                if (name == kOpNames + OP_COUNT) throw std::invalid_argument("Unknown op: " + kv.first);
+                options.weights[name - kOpNames] = std::stod(kv.second);
+            }
+        } else if (arg == "--sizes") {
+            options.sizes.clear();
+            for (const auto& kv : splitPairs(value(), ':')) {
+                options.sizes.emplace_back(std::stoul(kv.first), std::stod(kv.second));
+            }
+        } else if (arg == "--key-bits") {
+            options.keyBits = std::stoi(value());
+        } else if (arg == "--threads") {
+            options.threads = std::max(1, std::stoi(value()));
+        } else if (arg == "--duration") {
+            options.duration = std::stod(value());
+        } else if (arg == "--count") {
+            options.count = std::stoull(value());
+        } else if (arg == "--json") {
+            options.json = true;
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+    return options;
+}
+
+std::string randomMessage(size_t length, std::mt19937& gen) {
+    std::uniform_int_distribution<int> dist(32, 126);
+    std::string message(length, ' ');
+    for (auto& c : message) c = static_cast<char>(dist(gen));
+    return message;
+}
+
+void printText(const Options& options, const LatencyHistogram (&latency)[OP_COUNT], const uint64_t (&errors)[OP_COUNT], double elapsed) {
+    std::cout << "RSA load: " << options.keyBits << "-bit key, " << options.threads << " threads, "
+              << std::fixed << std::setprecision(2) << elapsed << " s\n";
+    std::cout << std::left << std::setw(9) << "op" << std::right
+              << std::setw(10) << "count" << std::setw(12) << "ops/s"
+              << std::setw(12) << "p50(us)" << std::setw(12) << "p90(us)" << std::setw(12) << "p99(us)"
+              << std::setw(12) << "p99.9(us)" << std::setw(12) << "max(us)" << std::setw(8) << "errors" << "\n";
+
+    LatencyHistogram all;
+    uint64_t allErrors = 0;
+    auto row = [&](const std::string& name, const LatencyHistogram& h, uint64_t errs) {
+        std::cout << std::left << std::setw(9) << name << std::right
+                  << std::setw(10) << h.total() << std::setw(12) << h.total() / elapsed
+                  << std::setw(12) << h.percentile(50) / 1e3 << std::setw(12) << h.percentile(90) / 1e3
+                  << std::setw(12) << h.percentile(99) / 1e3 << std::setw(12) << h.percentile(99.9) / 1e3
+                  << std::setw(12) << h.max() / 1e3 << std::setw(8) << errs << "\n";
+    };
+    for (int op = 0; op < OP_COUNT; ++op) {
+        if (latency[op].total() == 0) continue;
+        row(kOpNames[op], latency[op], errors[op]);
+        all.merge(latency[op]);
+        allErrors += errors[op];
+    }
+    row("total", all, allErrors);
+}
+
+void printJson(const Options& options, const LatencyHistogram (&latency)[OP_COUNT], const uint64_t (&errors)[OP_COUNT], double elapsed) {
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\"key_bits\":" << options.keyBits << ",\"threads\":" << options.threads
+              << ",\"elapsed_s\":" << elapsed << ",\"ops\":{";
+    bool first = true;
+    for (int op = 0; op < OP_COUNT; ++op) {
+        const LatencyHistogram& h = latency[op];
+        if (h.total() == 0) continue;
+        if (!first) std::cout << ",";
+        first = false;
+        std::cout << "\"" << kOpNames[op] << "\":{\"count\":" << h.total()
+                  << ",\"errors\":" << errors[op]
+                  << ",\"throughput_ops\":" << h.total() / elapsed
+                  << ",\"latency_us\":{\"min\":" << h.min() / 1e3
+                  << ",\"mean\":" << h.mean() / 1e3
+                  << ",\"p50\":" << h.percentile(50) / 1e3
+                  << ",\"p90\":" << h.percentile(90) / 1e3
+                  << ",\"p99\":" << h.percentile(99) / 1e3
+                  << ",\"p99.9\":" << h.percentile(99.9) / 1e3
+                  << ",\"max\":" << h.max() / 1e3 << "}}";
+    }
+    std::cout << "}}\n";
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << "\n";
+        usage();
+        return 1;
+    }
+
+    std::cerr << "Generating " << options.keyBits << "-bit key..." << std::endl;
+    BigNumber e, d, n;
+    generateRSAKeyPair_optimization(options.keyBits, e, d, n);
+
+    // 每种消息长度预先准备好签名和密文，verify/decrypt 直接取用
+    std::mt19937 setupGen(42);
+    std::vector<Sample> samples;
+    for (const auto& size : options.sizes) {
+        Sample sample;
+        sample.message = randomMessage(size.first, setupGen);
+        sample.signature = rsaSignChunks(sample.message, d, n, options.keyBits);
+        sample.ciphertext = rsaEncryptChunks(sample.message, e, n, options.keyBits);
+        samples.push_back(sample);
+    }
+
+    std::vector<double> sizeWeights;
+    for (const auto& size : options.sizes) sizeWeights.push_back(size.second);
+
+    std::vector<WorkerStats> stats(options.threads);
+    std::atomic<uint64_t> issued(0);
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(options.duration));
+
+    auto worker = [&](int index) {
+        std::mt19937 gen(1000 + index);
+        std::discrete_distribution<int> pickOp(options.weights, options.weights + OP_COUNT);
+        std::discrete_distribution<size_t> pickSize(sizeWeights.begin(), sizeWeights.end());
+        WorkerStats& mine = stats[index];
+
+        while (true) {
+            if (options.count) {
+                if (issued++ >= options.count) break;
+            } else if (std::chrono::steady_clock::now() >= deadline) {
+                break;
+            }
+
+            int op = pickOp(gen);
+            const Sample& sample = samples[pickSize(gen)];
+            auto t0 = std::chrono::steady_clock::now();
+            bool ok = true;
+            try {
+                switch (op) {
+                    case SIGN: rsaSignChunks(sample.message, d, n, options.keyBits); break;
+                    case VERIFY: ok = rsaVerifyChunks(sample.message, sample.signature, e, n); break;
+                    case ENCRYPT: rsaEncryptChunks(sample.message, e, n, options.keyBits); break;
+                    case DECRYPT: ok = rsaDecryptChunks(sample.ciphertext, d, n) == sample.message; break;
+                    case KEYGEN: {
+                        // generateRSAKeyPair_optimization 共用全局的 found_p/found_q，第一次之后只会返回缓存的密钥，
+                        // 这里用不依赖全局状态的生成函数，每次都真正生成一对新素数
+                        RSAPrivateKeyCRT key;
+                        generateRSAKeyPair_multiPrime(options.keyBits, 2, key);
+                        break;
+                    }
+                }
+            } catch (const std::exception&) {
+                ok = false;
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            mine.latency[op].record(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            if (!ok) ++mine.errors[op];
+        }
+    };
+
+    std::cerr << "Running..." << std::endl;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.threads; ++i) threads.emplace_back(worker, i);
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    LatencyHistogram latency[OP_COUNT];
+    uint64_t errors[OP_COUNT] = {};
+    for (const auto& s : stats) {
+        for (int op = 0; op < OP_COUNT; ++op) {
+            latency[op].merge(s.latency[op]);
+            errors[op] += s.errors[op];
+        }
+    }
+
+    if (options.json) {
+        printJson(options, latency, errors, elapsed);
+    } else {
+        printText(options, latency, errors, elapsed);
+    }
+    return 0;
+}
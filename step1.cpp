@@ -1,7 +1,11 @@
 #include <iostream>
 #include <cassert>
 #include <openssl/bn.h>
+#include <openssl/evp.h>
 #include "BigNumber.h"
+#include "GenerateKey.h"
+#include "RandomSource.h"
+#include "TaskPool.h"
 
 std::string openssl_op(const std::string& a, const std::string& b, char op) {
     BN_CTX* ctx = BN_CTX_new();
@@ -46,6 +50,92 @@ void testBinaryOp(const std::string& a, const std::string& b, char op, const std
     std::cout << "[PASS] " << name << " comparison\n\n";
 }
 
+std::string makeDigits(size_t n, unsigned seed) {
+    std::string s(1, '1' + seed % 9);
+    for (size_t i = 1; i < n; ++i) {
+        seed = seed * 1103515245 + 12345;
+        s += '0' + (seed >> 16) % 10;
+    }
+    return s;
+}
+
+// algorithm 为顶层应当选中的算法，确认每条路径确实被走到
+void testLargeMultiply(size_t lenA, size_t lenB, BigNumber::MultiplyAlgorithm algorithm, const std::string& name) {
+    assert(BigNumber::multiplyAlgorithm(lenA, lenB) == algorithm);
+    std::string a = makeDigits(lenA, lenA), b = makeDigits(lenB, lenB + 7);
+    std::string result = (BigNumber(a) * BigNumber(b)).toString();
+    std::string expected = openssl_op(a, b, '*');
+    std::cout << "BigNumber " << name << ": " << result.size() << " digits\n";
+    std::cout << "OpenSSL   " << name << ": " << expected.size() << " digits\n";
+    assert(result == expected);
+    std::cout << "[PASS] " << name << " comparison\n\n";
+}
+
+// 用带工作线程的私有任务池强制走并行分派，结果与串行计算比较
+void testParallelMultiply(size_t lenA, size_t lenB, BigNumber::MultiplyAlgorithm algorithm, const std::string& name) {
+    assert(BigNumber::multiplyAlgorithm(lenA, lenB) == algorithm);
+    BigNumber a(makeDigits(lenA, lenA + 3)), b(makeDigits(lenB, lenB + 11));
+
+    BigNumber::ParallelMultiply defaults = BigNumber::parallelMultiply;
+    TaskPool pool(3);
+    BigNumber::parallelMultiply.pool = &pool;
+    BigNumber parallel = a * b;
+    size_t forked = pool.spawnedTasks();
+    BigNumber::parallelMultiply.maxDepth = 0;
+    BigNumber serial = a * b;
+    BigNumber::parallelMultiply = defaults;
+
+    std::cout << name << ": " << forked << " tasks forked\n";
+    assert(forked > 0);
+    assert(parallel == serial);
+    std::cout << "[PASS] " << name << " matches serial result\n\n";
+}
+
+void testLargeSquare(size_t len, const std::string& name) {
+    assert(BigNumber::multiplyAlgorithm(len, len) == BigNumber::MultiplyAlgorithm::Ntt);
+    std::string a = makeDigits(len, len);
+    BigNumber A(a);
+    std::string result = (A * A).toString();
+    std::string expected = openssl_op(a, a, '*');
+    std::cout << "BigNumber " << name << ": " << result.size() << " digits\n";
+    std::cout << "OpenSSL   " << name << ": " << expected.size() << " digits\n";
+    assert(result == expected);
+    std::cout << "[PASS] " << name << " comparison\n\n";
+}
+
+void testBitOps(const std::string& a, int shift) {
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM *aa = BN_new(), *res = BN_new();
+    BN_dec2bn(&aa, a.c_str());
+
+    BigNumber A(a);
+    assert(A.bitLength() == BN_num_bits(aa));
+    for (int i : {0, 1, shift, A.bitLength() - 1, A.bitLength() + 5}) {
+        assert(A.testBit(i) == (BN_is_bit_set(aa, i) == 1));
+    }
+
+    BN_lshift(res, aa, shift);
+    char* left = BN_bn2dec(res);
+    assert((A << shift).toString() == left);
+    BN_rshift(res, aa, shift);
+    char* right = BN_bn2dec(res);
+    assert((A >> shift).toString() == right);
+
+    BigNumber B = A >> 7;
+    assert((A & B) + (A | B) == A + B);
+    BigNumber C = A;
+    C.setBit(shift);
+    assert(C.testBit(shift) && (C | A) == C);
+
+    std::cout << "BigNumber bits: " << A.bitLength() << ", << " << shift << " and >> " << shift << " checked\n";
+    std::cout << "OpenSSL   bits: " << BN_num_bits(aa) << "\n";
+    std::cout << "[PASS] bit operations comparison\n\n";
+
+    OPENSSL_free(left);
+    OPENSSL_free(right);
+    BN_free(aa); BN_free(res); BN_CTX_free(ctx);
+}
+
 std::string openssl_powmod(const std::string& base, const std::string& exp, const std::string& mod) {
     BN_CTX* ctx = BN_CTX_new();
     BIGNUM *b = BN_new(), *e = BN_new(), *m = BN_new(), *res = BN_new();
@@ -90,6 +180,32 @@ void testPowmodWithOpenSSL(const std::string& base, const std::string& exp, cons
     std::cout << "[PASS] powmod comparison\n\n";
 }
 
+void testMultiPowmodWithOpenSSL(const std::vector<std::pair<std::string, std::string>>& terms, const std::string& mod) {
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM *m = BN_new(), *b = BN_new(), *e = BN_new(), *t = BN_new(), *acc = BN_new();
+    BN_dec2bn(&m, mod.c_str());
+    BN_one(acc);
+
+    std::vector<std::pair<BigNumber, BigNumber>> bigTerms;
+    for (const auto& term : terms) {
+        BN_dec2bn(&b, term.first.c_str());
+        BN_dec2bn(&e, term.second.c_str());
+        BN_mod_exp(t, b, e, m, ctx);
+        BN_mod_mul(acc, acc, t, m, ctx);
+        bigTerms.emplace_back(BigNumber(term.first), BigNumber(term.second));
+    }
+
+    BigNumber res = BigNumber::multiPowmod(bigTerms, BigNumber(mod));
+    char* expected = BN_bn2dec(acc);
+    std::cout << "BigNumber multiPowmod (" << terms.size() << " terms): " << res.toString() << "\n";
+    std::cout << "OpenSSL   multiPowmod (" << terms.size() << " terms): " << expected << "\n";
+    assert(res.toString() == expected);
+    std::cout << "[PASS] multiPowmod comparison\n\n";
+
+    OPENSSL_free(expected);
+    BN_free(m); BN_free(b); BN_free(e); BN_free(t); BN_free(acc); BN_CTX_free(ctx);
+}
+
 void testModinvWithOpenSSL(const std::string& a, const std::string& mod) {
     BigNumber x(a), m(mod);
     BigNumber inv = x.modinv(m);
@@ -100,6 +216,52 @@ void testModinvWithOpenSSL(const std::string& a, const std::string& mod) {
     std::cout << "[PASS] modinv comparison\n\n";
 }
 
+void testPrimalityWithOpenSSL(const std::string& n) {
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM* nn = BN_new();
+    BN_dec2bn(&nn, n.c_str());
+
+    bool expected = BN_check_prime(nn, ctx, nullptr) == 1;
+    if (!expected) {
+        for (uint32_t p = 2; p <= 127; ++p) assert(BigNumber(n).modWord(p) != 0);
+    }
+    bool result = isProbablyPrime_bpsw(BigNumber(n));
+    std::cout << "BigNumber BPSW " << n << ": " << result << "\n";
+    std::cout << "OpenSSL   prime " << n << ": " << expected << "\n";
+    assert(result == expected);
+    // 素数必然通过 Miller-Rabin，不论随机底数如何选
+    if (expected) assert(isProbablyPrime_optimization(BigNumber(n)));
+    std::cout << "[PASS] primality comparison\n\n";
+
+    BN_free(nn); BN_CTX_free(ctx);
+}
+
+// RandomSource 的 ChaCha20 分组函数与 OpenSSL 的 ChaCha20 密钥流逐字对照（RFC 8439 2.3.2 的密钥和 nonce）
+void testChaCha20WithOpenSSL() {
+    uint8_t keyBytes[32], iv[16] = {1, 0, 0, 0, 0, 0, 0, 9, 0, 0, 0, 0x4a, 0, 0, 0, 0};
+    uint32_t key[8], nonce[3] = {0x09000000, 0x4a000000, 0};
+    for (int i = 0; i < 32; ++i) keyBytes[i] = i;
+    for (int i = 0; i < 8; ++i) key[i] = keyBytes[4 * i] | keyBytes[4 * i + 1] << 8 | keyBytes[4 * i + 2] << 16 | uint32_t(keyBytes[4 * i + 3]) << 24;
+
+    const int blocks = 4;
+    uint8_t zeros[64 * blocks] = {0}, stream[64 * blocks];
+    int length = 0;
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    EVP_EncryptInit_ex(ctx, EVP_chacha20(), nullptr, keyBytes, iv);
+    EVP_EncryptUpdate(ctx, stream, &length, zeros, sizeof(zeros));
+    EVP_CIPHER_CTX_free(ctx);
+
+    for (int b = 0; b < blocks; ++b) {
+        uint32_t out[16];
+        RandomSource::chacha20Block(key, 1 + b, nonce, out);
+        for (int i = 0; i < 16; ++i) {
+            const uint8_t* p = stream + 64 * b + 4 * i;
+            assert(out[i] == (p[0] | p[1] << 8 | p[2] << 16 | uint32_t(p[3]) << 24));
+        }
+    }
+    std::cout << "[PASS] ChaCha20 keystream comparison (" << blocks << " blocks)\n\n";
+}
+
 int main() {
     std::cout << "=== Basic Arithmetic Tests ===\n";
     testBinaryOp("12345678901234567890", "98765432109876543210", '+', "Addition");
@@ -108,9 +270,59 @@ int main() {
     testBinaryOp("98765432109876543210", "123456789", '/', "Division");
     testBinaryOp("98765432109876543210", "123456789", '%', "Modulus");
 
+    std::cout << "=== Large Multiplication Tests ===\n";
+    using Algo = BigNumber::MultiplyAlgorithm;
+    BigNumber::MultiplyThresholds defaults = BigNumber::multiplyThresholds;
+    // 默认阈值下的分派：Toom-3 只在超出 NTT 最大变换长度时出现
+    assert(defaults.karatsuba < defaults.ntt);
+    if (defaults.karatsuba > 1)
+        assert(BigNumber::multiplyAlgorithm(defaults.karatsuba - 1, defaults.karatsuba - 1) == Algo::Schoolbook);
+    assert(BigNumber::multiplyAlgorithm(defaults.karatsuba, defaults.karatsuba) == Algo::Karatsuba);
+    assert(BigNumber::multiplyAlgorithm(defaults.ntt - 1, defaults.ntt - 1) == Algo::Karatsuba);
+    assert(BigNumber::multiplyAlgorithm(3 * defaults.karatsuba, defaults.karatsuba) == Algo::Unbalanced);
+    assert(BigNumber::multiplyAlgorithm(defaults.ntt, defaults.ntt) == Algo::Ntt);
+    assert(BigNumber::multiplyAlgorithm(size_t(1) << 25, size_t(1) << 25) == Algo::Toom3);
+
+    BigNumber::multiplyThresholds.ntt = static_cast<size_t>(-1);
+    BigNumber::multiplyThresholds.toom3 = 1000;
+    testLargeMultiply(150, 140, Algo::Karatsuba, "Karatsuba multiplication");
+    testLargeMultiply(1500, 1400, Algo::Toom3, "Toom-3 multiplication");
+    testLargeMultiply(3000, 200, Algo::Unbalanced, "Unbalanced multiplication");
+    testParallelMultiply(900, 850, Algo::Karatsuba, "Parallel Karatsuba multiplication");
+    testParallelMultiply(3000, 2800, Algo::Toom3, "Parallel Toom-3 multiplication");
+    BigNumber::multiplyThresholds = defaults;
+    testLargeMultiply(200000, 150000, Algo::Ntt, "NTT multiplication");
+    testLargeSquare(100000, "NTT squaring");
+
+    std::cout << "=== Bit Operation Tests ===\n";
+    testBitOps("98765432109876543210", 13);
+    testBitOps(makeDigits(400, 3), 200);
+    testBitOps("4294967296", 32);
+
+    std::cout << "=== Primality Tests ===\n";
+    // 下面的合数都没有不超过 127 的因子，不会在试除阶段被淘汰
+    testPrimalityWithOpenSSL("1373653");             // 829 * 1657，以 2、3 为底的强伪素数，由 Lucas 检测淘汰
+    testPrimalityWithOpenSSL("3215031751");          // 151 * 751 * 28351，以 2、3、5、7 为底的强伪素数
+    testPrimalityWithOpenSSL("22499");               // 149 * 151，强 Lucas 伪素数，由以 2 为底的 Miller-Rabin 淘汰
+    testPrimalityWithOpenSSL("1194649");             // 1093^2，以 2 为底的强伪素数，走 Lucas 的完全平方判定
+    testPrimalityWithOpenSSL("4295098369");          // 65537^2，大素数的平方
+    testPrimalityWithOpenSSL("3825123056546413051"); // 对 2..23 为底都是强伪素数
+    testPrimalityWithOpenSSL("65537");               // 费马素数，随机底数不能取到 n
+    testPrimalityWithOpenSSL("1000000007");
+    testPrimalityWithOpenSSL("170141183460469231731687303715884105727");
+
+    std::cout << "=== Random Source Tests ===\n";
+    testChaCha20WithOpenSSL();
+
     std::cout << "=== Modular Arithmetic Tests ===\n";
     testPowmodWithOpenSSL("4", "13", "497");
     testPowmodWithOpenSSL("123456789", "65537", "987654321987654321");
+    testPowmodWithOpenSSL("123456789", "98765432109876543210987654321", "1000000000000000000000007");
+    testMultiPowmodWithOpenSSL({{"4", "13"}, {"7", "0"}, {"5", "3"}}, "497");
+    testMultiPowmodWithOpenSSL({{"123456789", "98765432109876543210987654321"}, {"987654321987654321", "65537"}},
+                               "1000000000000000000000007");
+    testMultiPowmodWithOpenSSL({{makeDigits(150, 1), makeDigits(150, 2)}, {makeDigits(140, 3), makeDigits(100, 4)},
+                                {makeDigits(90, 5), makeDigits(155, 6)}}, makeDigits(155, 7));
     testModinvWithOpenSSL("3", "11");
     testModinvWithOpenSSL("123456789", "1000000007");
 
@@ -3,6 +3,8 @@
 #include "BigNumber.h"
 #include "GenerateKey.h"
 #include "RsaCrypto.h"
+#include "RsaAsync.h"
+#include "ModulusCache.h"
 
 void testRSA(const std::string& message, const BigNumber& e, const BigNumber& d, const BigNumber& n, int keyBits) {
     std::cout << "测试消息: " << message << std::endl;
@@ -22,6 +24,27 @@ void testRSA(const std::string& message, const BigNumber& e, const BigNumber& d,
     std::cout << "------------------------------------" << std::endl;
 }
 
+void testRSA_crt(const std::string& message, const RSAPrivateKeyCRT& key, int keyBits) {
+    std::cout << "测试消息(" << key.primes.size() << " 素数 CRT): " << message << std::endl;
+
+    try {
+        auto ciphertexts = rsaEncryptChunks(message, key.e, key.n, keyBits);
+        // CRT 运算不应把素因子放进共享的模数缓存
+        uint64_t misses = ModulusCache::shared().stats().misses;
+        std::string decrypted = rsaDecryptChunks_crt(ciphertexts, key);
+        std::cout << (message == decrypted ? "CRT 解密测试成功！" : "CRT 解密测试失败！") << std::endl;
+        auto signature = rsaSignChunks_crt(message, key, keyBits);
+        bool cacheClean = ModulusCache::shared().stats().misses == misses;
+        std::cout << (cacheClean ? "CRT 缓存隔离测试成功！" : "CRT 缓存隔离测试失败！") << std::endl;
+        bool verified = rsaVerifyChunks(message, signature, key.e, key.n);
+        std::cout << (verified ? "CRT 签名验签测试成功！" : "CRT 签名验签测试失败！") << std::endl;
+    } catch (const std::exception& ex) {
+        std::cout << "测试过程中出现异常: " << ex.what() << std::endl;
+    }
+
+    std::cout << "------------------------------------" << std::endl;
+}
+
 int main() {
     BigNumber e, d, n;
     int keyBits = 512;
@@ -43,6 +66,104 @@ int main() {
         testRSA(msg, e, d, n, keyBits);
     }
 
+    std::vector<std::pair<std::string, std::vector<BigNumber>>> batch;
+    for (const auto& msg : testMessages) {
+        batch.emplace_back(msg, rsaSignChunks(msg, d, n, keyBits));
+    }
+    batch.emplace_back("Tampered message", batch[0].second);
+    std::vector<bool> results = rsaVerifyBatch(batch, e, n);
+    bool batchOk = !results.back();
+    for (size_t i = 0; i + 1 < results.size(); ++i) batchOk = batchOk && results[i];
+    std::cout << (batchOk ? "批量验签测试成功！" : "批量验签测试失败！") << std::endl;
+    std::cout << "------------------------------------" << std::endl;
+
+    // 满宽度打包：覆盖空消息、恰好填满一块的长度头+消息、跨多块的长消息
+    int packedBits = n.bitLength();
+    size_t payload = (packedBits - 1) / 8, width = (packedBits + 7) / 8;
+    bool packedOk = true;
+    for (size_t length : {size_t(0), payload - 4, payload, size_t(1000)}) {
+        std::string msg(length, '\0');
+        for (size_t i = 0; i < length; ++i) msg[i] = static_cast<char>(i * 131 + 7);
+        auto packed = rsaEncryptPacked(msg, e, n);
+        size_t blocks = (length + 4 + payload - 1) / payload;
+        packedOk = packedOk && packed.size() == blocks * width && rsaDecryptPacked(packed, d, n) == msg;
+    }
+    std::cout << (packedOk ? "满宽度打包加解密测试成功！" : "满宽度打包加解密测试失败！") << std::endl;
+    std::cout << "------------------------------------" << std::endl;
+
+    // 模数上下文缓存：上面的调用都命中同一个 n；两项容量的分片里放入三个模数必然淘汰最久未用的一项
+    ModulusCacheStats sharedStats = ModulusCache::shared().stats();
+    ModulusCache smallCache(ModulusContext(n).footprint() * 2, 1);
+    BigNumber two(2);
+    smallCache.get(n);
+    smallCache.get(n + two);
+    smallCache.get(n);
+    smallCache.get(n + two + two);
+    ModulusCacheStats smallStats = smallCache.stats();
+    bool cacheOk = sharedStats.hits > 0 && sharedStats.misses >= 1
+        && smallStats.hits == 1 && smallStats.misses == 3 && smallStats.evictions == 1 && smallStats.entries == 2
+        && smallCache.get(n)->modulus() == n && smallCache.stats().hits == 2;
+    std::cout << (cacheOk ? "模数上下文缓存测试成功！" : "模数上下文缓存测试失败！") << std::endl;
+    std::cout << "------------------------------------" << std::endl;
+
+    auto signJob = rsaSignChunksAsync(testMessages[0], d, n, keyBits);
+    auto verifyJob = rsaVerifyChunksAsync(testMessages[0], signJob.result.get(), e, n);
+    std::cout << (verifyJob.result.get() ? "异步签名验签测试成功！" : "异步签名验签测试失败！") << std::endl;
+
+    // 单线程池：第一个任务阻塞住工作线程，第二个任务仍在队列中，可以取消
+    RsaWorkerPool pool(1);
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    auto blocker = pool.submit("key", [gate]() { gate.wait(); return true; });
+    auto queuedJob = pool.submit("key", []() { return true; });
+    while (pool.inFlight() == 0) std::this_thread::yield();
+    bool cancelled = pool.cancel(queuedJob.id) && pool.queueDepth() == 0;
+    release.set_value();
+    blocker.result.get();
+    try {
+        queuedJob.result.get();
+        cancelled = false;
+    } catch (const std::runtime_error&) {
+    }
+    std::cout << (cancelled ? "异步任务取消测试成功！" : "异步任务取消测试失败！") << std::endl;
+    std::cout << "------------------------------------" << std::endl;
+
+    // Fiat 批量解密：同一模数、指数 3/5/7/11 的四个密文一次解出
+    RSABatchKeySet batchKeys;
+    std::cout << "生成 " << keyBits << " 位批量 RSA 密钥组..." << std::endl;
+    generateRSABatchKeySet(keyBits, 4, batchKeys);
+    std::vector<BigNumber> batchPlain;
+    std::vector<std::pair<size_t, BigNumber>> batchItems;
+    for (size_t i = 0; i < batchKeys.exponents.size(); ++i) {
+        batchPlain.push_back(bytesToBigNumber(std::vector<uint8_t>(testMessages[i].begin(), testMessages[i].end())) % batchKeys.n);
+        batchItems.emplace_back(i, batchPlain[i].powmod(batchKeys.exponents[i], batchKeys.n));
+    }
+    bool batchDecryptOk = rsaBatchDecrypt(batchItems, batchKeys) == batchPlain;
+    // 密文 0 和素因子的倍数与 n 不互素，不能参与批量求逆，也不能让同批其他密文解错
+    batchItems[1].second = BigNumber(0);
+    batchPlain[1] = BigNumber(0);
+    batchPlain[2] = batchKeys.primes[0];
+    batchItems[2].second = batchPlain[2].powmod(batchKeys.exponents[2], batchKeys.n);
+    batchDecryptOk = batchDecryptOk && rsaBatchDecrypt(batchItems, batchKeys) == batchPlain;
+    std::cout << (batchDecryptOk ? "批量解密测试成功！" : "批量解密测试失败！") << std::endl;
+    std::cout << "------------------------------------" << std::endl;
+
+    for (int primeCount : {3, 4}) {
+        RSAPrivateKeyCRT key;
+        std::cout << "生成 " << keyBits << " 位 " << primeCount << " 素数 RSA 密钥..." << std::endl;
+        generateRSAKeyPair_multiPrime(keyBits, primeCount, key);
+        // 每个素数只保证最高两位为 1，三、四个素数之积可能少一位，生成时必须补足
+        bool exactBits = key.n.bitLength() == keyBits;
+        for (int i = 0; i < 16 && exactBits; ++i) {
+            RSAPrivateKeyCRT small;
+            generateRSAKeyPair_multiPrime(256, primeCount, small);
+            exactBits = small.n.bitLength() == 256;
+        }
+        std::cout << (exactBits ? "模数位数测试成功！" : "模数位数测试失败！") << std::endl;
+        testRSA_crt(testMessages[0], key, keyBits);
+        testRSA_crt(testMessages.back(), key, keyBits);
+    }
+
     return 0;
 }
 